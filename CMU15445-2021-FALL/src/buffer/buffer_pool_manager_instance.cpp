@@ -40,23 +40,47 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include "buffer/page_compressor.h"
 #include "common/macros.h"
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, size_t clean_reserve,
+                                                     ReplacerType replacer_type, size_t replacer_k,
+                                                     size_t max_pool_size, size_t compressed_cache_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, clean_reserve, replacer_type, replacer_k,
+                                PageRouting::MODULO, PageRouter::DEFAULT_EXTENT_SIZE, FrameArena::NO_NUMA_NODE,
+                                max_pool_size, compressed_cache_size) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     size_t clean_reserve, ReplacerType replacer_type,
+                                                     size_t replacer_k, PageRouting routing, uint32_t extent_size,
+                                                     int numa_node, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
     : pool_size_(pool_size),            //pool_size_ = pool_size
+      max_pool_size_(std::max(pool_size, max_pool_size)),
       num_instances_(num_instances),    //num_instances_ = num_instances
       instance_index_(instance_index),  //instance_index_ = instance_index
-      next_page_id_(instance_index),    //next_page_id_ = next_page_id
+      router_(routing, num_instances, extent_size),
+      use_extents_(num_instances == 1 || router_.GetExtentSize() % DiskSpaceManager::EXTENT_SIZE == 0),
+      frame_arena_(max_pool_size_ * (PAGE_SIZE + sizeof(Page)), numa_node),
       disk_manager_(disk_manager),      //disk_manager_ = disk_manager
-      log_manager_(log_manager) {       //log_manager_ = log_manager
+      log_manager_(log_manager),        //log_manager_ = log_manager
+      page_table_(max_pool_size_),
+      free_list_(max_pool_size_),
+      available_frames_(static_cast<int>(pool_size)),
+      clean_reserve_(clean_reserve) {
+  if (compressed_cache_size > 0) {
+    compressed_cache_ = std::make_unique<CompressedPageCache>(compressed_cache_size);
+  }
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");  //BPIǳصһ֣ôشСӦֻ1
   BUSTUB_ASSERT(
       instance_index < num_instances,
@@ -65,189 +89,747 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
 
   // We allocate a consecutive memory space for the buffer pool.
   // Ϊطһڴռ䡣
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // The page data comes first, so every frame is page aligned; the Page objects follow it, densely packed. Frames
+  // reserved for Resize() are set up as well, but their data is not touched, so it takes no memory until it is used.
+  char *data = frame_arena_.Data();
+  pages_ = reinterpret_cast<Page *>(data + max_pool_size_ * PAGE_SIZE);
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (&pages_[i]) Page(data + i * PAGE_SIZE);
+    pages_[i].pin_count_ = FRAME_LOCKED;
+  }
+  if (replacer_type == ReplacerType::LRU_K) {
+    replacer_ = new LRUKReplacer(max_pool_size_, replacer_k);
+  } else if (replacer_type == ReplacerType::CLOCK) {
+    replacer_ = new ClockReplacer(max_pool_size_);
+  } else {
+    replacer_ = new LRUReplacer(max_pool_size_);
+  }
 
   // Initially, every page is in the free list.
   // ÿҳ涼ڿвλfree_list_С
   for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+    free_list_.PushBack(static_cast<frame_id_t>(i));
+  }
+
+  if (clean_reserve_ > 0) {
+    cleaner_thread_ = std::thread(&BufferPoolManagerInstance::RunCleaner, this);
+    if (GetNumaNode() != FrameArena::NO_NUMA_NODE) {
+      FrameArena::BindThread(&cleaner_thread_, GetNumaNode());
+    }
   }
 }
 
 // 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopPrefetcher();
+  if (cleaner_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(cleaner_latch_);
+      stop_cleaner_ = true;
+    }
+    cleaner_cv_.notify_one();
+    cleaner_thread_.join();
+  }
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
   delete replacer_;
 }
 
 // FlushPgImpʽؽҳдش̡
-bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) { 
-    frame_id_t frame_id;
-    std::lock_guard<std::mutex> lock(latch_);                       //
-    if (page_table_.count(page_id) == 0) {                          //вڶӦҳIDҳ
-        return false;                                               //false
-    }                                                               //
-    frame_id = page_table_[page_id];                                //ȡӦҳҳID
-    pages_[frame_id].is_dirty_ = false;                             //ڵĸҳis_dirty_Ϊfalse
-    disk_manager_->WritePage(page_id, pages_[frame_id].GetData());  //ʹWritePageҳʵdata_дش
-    return true;                                                    //true
+bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
+  // The page is pinned, so it stays resident, and written with latch_ released; its read latch keeps writers out.
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id) || !TryPinForFlush(frame_id, page_id)) {
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(&lock);
+    // Frames are only loaded under latch_, so a resident frame cannot be FRAME_LOCKED here.
+    if (!page_table_.Find(page_id, &frame_id) || !TryPinForFlush(frame_id, page_id)) {
+      return false;
+    }
+  }
+  Page *page = &pages_[frame_id];
+  page->RLatch();
+  if (page->is_dirty_.exchange(false)) {
+    stats_.Add(BufferPoolCounter::DIRTY_WRITEBACKS);
+  }
+  disk_manager_->WritePage(page_id, page->GetData());
+  page->RUnlatch();
+  ReleasePin(frame_id);
+  return true;
 }
 
 //  FlushAllPgsImpڵҳдش̡
-  void BufferPoolManagerInstance::FlushAllPgsImp() { 
-    std::lock_guard<std::mutex> lock(latch_);     // 
-    for (auto id : page_table_) {                 // page_table_Իûڵ<ҳID - λID>
-        pages_[id.second].is_dirty_ = false;      // ҳis_dirty_Ϊfalse
-        disk_manager_->WritePage(id.first, pages_[id.second].GetData());    //ʹWritePageҳʵdata_дش
+void BufferPoolManagerInstance::FlushAllPgsImp() { FlushDirtyPages({this}); }
+
+void BufferPoolManagerInstance::FlushDirtyPages(const std::vector<BufferPoolManagerInstance *> &instances) {
+  // Snapshot the dirty pages without any latch. Pages dirtied after this point are left for the next flush; pages
+  // evicted meanwhile have been written back by the evictor and are skipped below.
+  std::vector<std::pair<page_id_t, size_t>> dirty_pages;
+  for (size_t idx = 0; idx < instances.size(); idx++) {
+    for (size_t i = 0; i < instances[idx]->GetPoolSize(); i++) {
+      const page_id_t page_id = instances[idx]->pages_[i].page_id_;
+      if (page_id != INVALID_PAGE_ID && instances[idx]->pages_[i].IsDirty()) {
+        dirty_pages.emplace_back(page_id, idx);
+      }
     }
   }
-
-//GetFrame() ȡframe_id뺯ǰ
-frame_id_t BufferPoolManagerInstance::GetFrame() { 
-    frame_id_t new_frame_id;
-    if (!free_list_.empty()) {                                  //free_list_Ϊգڿҳ
-        new_frame_id = free_list_.back();                       // frame_idΪ free_list_βڵֵ
-        free_list_.pop_back();                                  //free_list_ɾβڵ
+  if (dirty_pages.empty()) {
+    return;
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+
+  // Images are copied in page id order, so a run of adjacent pages is contiguous in memory and written in place.
+  std::unique_ptr<char, decltype(&free)> images(
+      static_cast<char *>(aligned_alloc(PAGE_SIZE, std::min(dirty_pages.size(), FLUSH_BATCH_PAGES) * PAGE_SIZE)),
+      &free);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  std::vector<std::pair<size_t, frame_id_t>> pinned;
+  std::vector<size_t> pins_per_instance(instances.size(), 0);
+  auto write_batch = [&] {
+    if (!batch.empty()) {
+      instances[0]->disk_manager_->WritePages(&batch);
     }
-    bool res = replacer_->Victim(&new_frame_id);                //free_list_Ϊգڿҳ,Victim()frame_idֵ
-    if (!res) {                                                 //޿ҳ棬ֵʧ
-        return NUMLL_FRAME;                                     //NUMLL_FRAME
+    for (const auto &[idx, frame_id] : pinned) {
+      instances[idx]->ReleasePin(frame_id);
     }
-    page_id_t victim_page_id = pages_[new_frame_id].page_id_;   //ȡҳ֮ǰҳID
-    if (pages_[new_frame_id].IsDirty()) {                       //ҳΪҳ
-        disk_manager_->WritePage(victim_page_id, pages_[new_frame_id].GetData());   //д
-    }       
-    page_table_.erase(victim_page_id);                          //ϣpage_table_<ҳID - βڵ>ӳ
-
-    return new_frame_id;                                        //ҳID
+    batch.clear();
+    pinned.clear();
+    std::fill(pins_per_instance.begin(), pins_per_instance.end(), 0);
+  };
+
+  for (const auto &[page_id, idx] : dirty_pages) {
+    BufferPoolManagerInstance *instance = instances[idx];
+    if (pinned.size() == FLUSH_BATCH_PAGES ||
+        pins_per_instance[idx] == std::max<size_t>(1, instance->GetPoolSize() / FLUSH_PIN_DIVISOR)) {
+      write_batch();
+    }
+    frame_id_t frame_id;
+    if (!instance->page_table_.Find(page_id, &frame_id) || !instance->TryPinForFlush(frame_id, page_id)) {
+      continue;
+    }
+    // The pin keeps the page from being evicted, and re-read from a stale disk image, before the batch is written.
+    pinned.emplace_back(idx, frame_id);
+    pins_per_instance[idx]++;
+    Page *page = &instance->pages_[frame_id];
+    char *image = images.get() + batch.size() * PAGE_SIZE;
+    page->RLatch();
+    const bool is_dirty = page->is_dirty_.exchange(false);
+    if (is_dirty) {
+      memcpy(image, page->GetData(), PAGE_SIZE);
+    }
+    page->RUnlatch();
+    if (is_dirty) {
+      batch.emplace_back(page_id, image);
+      instance->stats_.Add(BufferPoolCounter::DIRTY_WRITEBACKS);
+    }
+  }
+  write_batch();
 }
-    
- // NewPgImpڴзµҳ棬أָ򻺳ҳPageָ롣
-Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) { 
-    std::lock_guard<std::mutex> lock(latch_);       //
-    frame_id_t new_frame_id;
-    page_id_t new_page_id;
-    new_frame_id = GetFrame();                      //GetFrame()ȡframe_id
-    if (new_frame_id == NUMLL_FRAME) {              //ûпвλͿɱλ
-        return nullptr;                             //ؿָ
+
+//GetFrame() ȡframe_id뺯ǰ
+frame_id_t BufferPoolManagerInstance::GetFrame(std::unique_lock<std::mutex> *lock) {
+  while (!free_list_.Empty()) {
+    // Free frames already carry FRAME_LOCKED, so no optimistic reader can pin them.
+    const frame_id_t frame_id = free_list_.PopBack();
+    // A frame past pool_size_ is being retired by a shrink, which finds it off the free list and takes it from here.
+    if (static_cast<size_t>(frame_id) < pool_size_.load(std::memory_order_relaxed)) {
+      return frame_id;
     }
-    new_page_id = AllocatePage();   //ڿɱλ`AllocatePage()`Ϊµҳ`page_id`ҳID
+  }
 
-    page_table_[new_page_id] = new_frame_id;        //`page_table_`ɾĿλеԭҳIDӳ䣬µ<ҳID - λID>ӳ
+  frame_id_t frame_id;
+  while (replacer_->Victim(&frame_id)) {
+    // Frames past pool_size_ are left for the shrink that retires them.
+    if (static_cast<size_t>(frame_id) >= pool_size_.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    // The replacer only holds a hint: a lock-free fetch may have pinned the frame after it was unpinned. Claim the
+    // frame by moving its pin count from 0 to FRAME_LOCKED; if that fails, the frame is in use and will be handed back
+    // to the replacer by its last UnpinPage.
+    int expected = 0;
+    if (!pages_[frame_id].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+      continue;
+    }
+    Page *victim = &pages_[frame_id];
+
+    // The cleaner fell behind and the victim is dirty. Turn the claim into a pin so the page stays resident and
+    // readable, write it back with latch_ released, then try to claim it again.
+    while (victim->IsDirty()) {
+      stats_.Add(BufferPoolCounter::DIRTY_WRITE_STALLS);
+      UnlockFrame(frame_id, 1);
+      available_frames_.fetch_sub(1, std::memory_order_relaxed);
+      cleaner_cv_.notify_one();
+      lock->unlock();
+      WriteBack(frame_id);
+      lock->lock();
+      expected = 1;
+      if (!victim->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+        // Someone fetched the page meanwhile, so it is no longer a victim.
+        ReleasePin(frame_id);
+        victim = nullptr;
+        break;
+      }
+      available_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (victim == nullptr) {
+      continue;
+    }
 
-    pages_[new_frame_id].page_id_ = new_page_id;    //²λҳԪ
-    pages_[new_frame_id].is_dirty_ = false;
-    pages_[new_frame_id].pin_count_ = 1;
-    pages_[new_frame_id].ResetMemory();             //ҳбݹ㡣
-    //ʱҳݣ轫ݴӴд뻺
+    page_table_.Erase(victim->page_id_);
+    stats_.Add(BufferPoolCounter::EVICTIONS);
+    if (compressed_cache_ != nullptr) {
+      CompressEvicted(victim, lock);
+    }
+    return frame_id;
+  }
+  return NUMLL_FRAME;
+}
 
-     /*
-     ҳҲҪдش̣ newpage unpin Ȼٱ̭ȥ fetchpageʱͻᱨ
-     в޴ҳֱis_dirty_ΪtrueԻᱨ
-     */
-    disk_manager_->WritePage(new_page_id, pages_[new_frame_id].GetData());
+void BufferPoolManagerInstance::CompressEvicted(Page *page, std::unique_lock<std::mutex> *lock) {
+  const page_id_t page_id = page->page_id_;
+  // A fetch or delete of the page while latch_ is released cancels the reservation, so a stale copy is not cached.
+  const uint64_t ticket = compressed_cache_->Reserve(page_id);
+  lock->unlock();
+  std::array<char, CompressedPageCache::MAX_COMPRESSED_SIZE> compressed;
+  const size_t size = PageCompressor::Compress(page->GetData(), PAGE_SIZE, compressed.data(), compressed.size());
+  lock->lock();
+  compressed_cache_->Insert(page_id, ticket, compressed.data(), size);
+}
 
-    return &pages_[new_frame_id];                   // ָ򻺳ҳPageָ
+frame_id_t BufferPoolManagerInstance::TakeRingFrame(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (page_id == INVALID_PAGE_ID || !page_table_.Find(page_id, &frame_id) ||
+      static_cast<size_t>(frame_id) >= pool_size_.load(std::memory_order_relaxed)) {
+    return NUMLL_FRAME;
+  }
+  // Someone else is using the page now; leave it to the regular replacement policy.
+  Page *page = &pages_[frame_id];
+  int expected = 0;
+  if (!page->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+    return NUMLL_FRAME;
+  }
+  // Do not wait for a write back on the scan path either. The frame is still in the replacer, so releasing the claim
+  // leaves it evictable as before.
+  if (page->IsDirty()) {
+    UnlockFrame(frame_id, 0);
+    return NUMLL_FRAME;
+  }
+
+  page_table_.Erase(page_id);
+  stats_.Add(BufferPoolCounter::EVICTIONS);
+  std::lock_guard<std::mutex> replacer_lock(replacer_latch_);
+  replacer_->Remove(frame_id);
+  return frame_id;
 }
 
-//FetchPgImpĹǻȡӦҳIDҳ棬ָҳָ
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id){ 
-    std::lock_guard<std::mutex> lock(latch_);       //
-    frame_id_t frame_id;
-    if (page_table_.count(page_id) > 0) {           //شڶӦҳ
-        frame_id = page_table_[page_id];            //ȡӦҳID
-        if (pages_[frame_id].pin_count_ == 0) {     //֮ǰҳûûPin̶ҳֹ
-            replacer_.Pin(frame_id);                //ûѾ̶
-        }
-        pages_[frame_id].pin_count_++;              //ҳû
-        return &pages_[frame_id];
-    }
-    frame_id = GetFrame();                          //ûжӦҳ棬GetFrame()
-    if (frame_id == NUMLL_FRAME) {                  //ûпҳͿҳ
-        return nullptr;                             //nullptr
-    }
-                                                    
-    page_table_[page_id] = frame_id;                //¹ϣӳ
-    
-    pages_[frame_id].is_dirty_ = false;             //²λҳԪ
-    pages_[frame_id].pin_count_ = 1;
-    pages_[frame_id].page_id_ = page_id;
-
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());   //ҳд뻺
-    return &pages_[frame_id];                       // ָ򻺳ҳPageָ
-} 
-
-  
-bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
-    std::lock_guard<std::mutex> lock(latch_);   // 
-    frame_id_t frame_id;
-    if (page_table_.count(page_id) == 0) {      //ҳǷڻ
-        return true;                            //δ򷵻True
+bool BufferPoolManagerInstance::Resize(size_t new_size) {
+  if (new_size == 0 || new_size > max_pool_size_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> resize_lock(resize_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  const size_t old_size = pool_size_.load(std::memory_order_relaxed);
+  if (new_size >= old_size) {
+    for (size_t i = old_size; i < new_size; i++) {
+      free_list_.PushBack(static_cast<frame_id_t>(i));
     }
-    frame_id = page_table_[page_id];            //ȡframe_id
+    available_frames_.fetch_add(static_cast<int>(new_size - old_size), std::memory_order_relaxed);
+    pool_size_.store(new_size, std::memory_order_release);
+    return true;
+  }
 
-    if (pages_[frame_id].pin_count_ != 0) {     //ҳû`pin_count_`ǷΪ0
-        return false;                           //0򷵻False
+  // From here on no page is loaded into the frames past new_size, so each can be retired once its page is unpinned.
+  pool_size_.store(new_size, std::memory_order_release);
+  std::vector<bool> retired(old_size - new_size, false);
+  size_t remaining = retired.size();
+  const auto deadline = std::chrono::steady_clock::now() + RESIZE_DRAIN_TIMEOUT;
+  while (true) {
+    for (size_t i = old_size; i-- > new_size;) {
+      if (!retired[i - new_size] && RetireFrame(static_cast<frame_id_t>(i), &lock)) {
+        retired[i - new_size] = true;
+        remaining--;
+      }
     }
+    if (remaining == 0 || std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    lock.lock();
+  }
 
-    /*
-    Ҫдҳҳɾ
-    if (pages_[frame_id].IsDirty) {
-        pages_[frame_id].is_dirty_ = false;
-        disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  // Keep the frames up to the last one that stayed pinned, putting the retired ones among them back on the free list.
+  size_t final_size = new_size;
+  for (size_t i = old_size; i > new_size; i--) {
+    if (!retired[i - 1 - new_size]) {
+      final_size = i;
+      break;
     }
-    */
+  }
+  for (size_t i = new_size; i < final_size; i++) {
+    if (retired[i - new_size]) {
+      free_list_.PushBack(static_cast<frame_id_t>(i));
+      available_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  pool_size_.store(final_size, std::memory_order_release);
+  lock.unlock();
+  if (final_size < old_size) {
+    frame_arena_.Release(pages_[final_size].GetData(), (old_size - final_size) * PAGE_SIZE);
+  }
+  return final_size == new_size;
+}
 
-    page_table_.erase(page_id);                     //ɾϣӳ
-    replacer_->Pin(frame_id);                       //̶ҳID
-    free_list_.emplace_back(frame_id);              //ڿβӽڵ
+bool BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *lock) {
+  Page *page = &pages_[frame_id];
+  // Under latch_, a frame that is FRAME_LOCKED but not on the free list was popped by GetFrame after the shrink began.
+  if (!free_list_.Remove(frame_id) && page->pin_count_.load() >= 0) {
+    int expected = 0;
+    if (!page->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+      return false;
+    }
+    // Write a dirty page back with latch_ released, as GetFrame does, then claim the frame again.
+    while (page->IsDirty()) {
+      UnlockFrame(frame_id, 1);
+      available_frames_.fetch_sub(1, std::memory_order_relaxed);
+      lock->unlock();
+      WriteBack(frame_id);
+      lock->lock();
+      expected = 1;
+      if (!page->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+        ReleasePin(frame_id);
+        return false;
+      }
+      available_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    page_table_.Erase(page->page_id_);
+    stats_.Add(BufferPoolCounter::EVICTIONS);
+    if (compressed_cache_ != nullptr) {
+      CompressEvicted(page, lock);
+    }
+    std::lock_guard<std::mutex> replacer_lock(replacer_latch_);
+    replacer_->Remove(frame_id);
+  }
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  available_frames_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
 
-    pages_[frame_id].page_id_ = INVALID_PAGE_ID;    //²λҳԪ
+// NewPgImpڴзµҳ棬أָ򻺳ҳPageָ롣
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) { return NewPgExtentImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::NewPgExtentImp(page_id_t *page_id, DiskExtent *extent) {
+  std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+  LockLatch(&lock);
+  const frame_id_t frame_id = GetFrame(&lock);
+  if (frame_id == NUMLL_FRAME) {
+    stats_.Add(BufferPoolCounter::PIN_FAILURES);
+    return nullptr;
+  }
+  const page_id_t new_page_id = AllocatePage(extent);
+  // A reused page id must not bring back the image of the page that was deleted.
+  if (compressed_cache_ != nullptr) {
+    compressed_cache_->Erase(new_page_id);
+  }
+
+  Page *page = &pages_[frame_id];
+  page->page_id_ = new_page_id;
+  page->ResetMemory();
+  // The page does not exist on disk yet; marking it dirty gets the zeroed image written before it is ever evicted.
+  page->is_dirty_ = true;
+
+  page_table_.Insert(new_page_id, frame_id);
+  UnlockFrame(frame_id, 1);
+  available_frames_.fetch_sub(1, std::memory_order_relaxed);
+  // Count the first access for replacers that keep access history.
+  SyncReplacer(frame_id);
+  *page_id = new_page_id;
+  return page;
+}
+
+//FetchPgImpĹǻȡӦҳIDҳ棬ָҳָ
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchPgStrategyImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  BufferPoolStatsRecorder::FetchTimer timer(&stats_);
+  // Fast path: a resident page is found and pinned without taking latch_.
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id) && TryPinResident(frame_id, page_id)) {
+    stats_.Add(BufferPoolCounter::HITS);
+    return &pages_[frame_id];
+  }
+
+  std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+  LockLatch(&lock);
+  if (page_table_.Find(page_id, &frame_id)) {
+    // Frames are only loaded under latch_, so a resident frame cannot be FRAME_LOCKED here; it can be pinned too often.
+    const int pin_count = TryAddPin(frame_id);
+    if (pin_count < 0) {
+      stats_.Add(BufferPoolCounter::PIN_FAILURES);
+      return nullptr;
+    }
+    if (pin_count == 0) {
+      SyncReplacer(frame_id);
+    }
+    stats_.Add(BufferPoolCounter::HITS);
+    return &pages_[frame_id];
+  }
+
+  // A scan first recycles the frame of the page it read ring_size misses ago.
+  page_id_t *ring_slot = strategy == nullptr ? nullptr : strategy->NextSlot(this);
+  frame_id = ring_slot == nullptr ? NUMLL_FRAME : TakeRingFrame(*ring_slot);
+  if (frame_id == NUMLL_FRAME) {
+    frame_id = GetFrame(&lock);
+  }
+  if (frame_id == NUMLL_FRAME) {
+    stats_.Add(BufferPoolCounter::PIN_FAILURES);
+    return nullptr;
+  }
+  // GetFrame may have released latch_ to write back a victim, and another thread may have loaded the page by now.
+  frame_id_t resident_frame_id;
+  if (page_table_.Find(page_id, &resident_frame_id)) {
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
     pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 0;
+    free_list_.PushBack(frame_id);
+    const int pin_count = TryAddPin(resident_frame_id);
+    if (pin_count < 0) {
+      stats_.Add(BufferPoolCounter::PIN_FAILURES);
+      return nullptr;
+    }
+    if (pin_count == 0) {
+      SyncReplacer(resident_frame_id);
+    }
+    stats_.Add(BufferPoolCounter::HITS);
+    return &pages_[resident_frame_id];
+  }
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  if (compressed_cache_ != nullptr && compressed_cache_->Take(page_id, page->GetData())) {
+    stats_.Add(BufferPoolCounter::COMPRESSED_HITS);
+  } else {
+    disk_manager_->ReadPage(page_id, page->GetData());
+    stats_.Add(BufferPoolCounter::MISSES);
+  }
 
-    DeallocatePage(page_id);                        //ɾ϶Ӧҳ
+  page_table_.Insert(page_id, frame_id);
+  UnlockFrame(frame_id, 1);
+  available_frames_.fetch_sub(1, std::memory_order_relaxed);
+  SyncReplacer(frame_id);
+  if (ring_slot != nullptr) {
+    *ring_slot = page_id;
+  }
+  return page;
+}
 
-    return true;
+bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    frame_id_t frame_id;
+    if (!page_table_.Find(page_id, &frame_id)) {
+      if (compressed_cache_ != nullptr) {
+        compressed_cache_->Erase(page_id);
+      }
+    } else {
+      // Only an unpinned page can be deleted; claiming the frame also keeps lock-free fetches away from it.
+      int expected = 0;
+      if (!pages_[frame_id].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+        return false;
+      }
+
+      // Ҫдأҳ漴ɾ
+      page_table_.Erase(page_id);
+      {
+        std::lock_guard<std::mutex> replacer_lock(replacer_latch_);
+        replacer_->Remove(frame_id);
+      }
+      free_list_.PushBack(frame_id);
+
+      pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+      pages_[frame_id].is_dirty_ = false;
+    }
+  }
+  // The page is out of the pool by now; giving its space back to the disk may punch a hole, so latch_ is released.
+  DeallocatePage(page_id);
+  return true;
 }
- 
+
 //UnpinPgImpĹΪṩû򻺳֪ͨҳʹϵĽӿڣ
 //ûʹҳҳIDԼʹùǷԸҳ޸ġ
 bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
-    std::lock_guard<std::mutex> lock(latch_);   //
-    frame_id_t frame_id;
-    if (page_table_.count(page_id) == 0) {      //ҳǷڻ
-        return true;                            //δڻ򷵻True
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return true;
+  }
+  Page *page = &pages_[frame_id];
+  if (page->page_id_ != page_id) {
+    // The caller did not hold a pin, so the frame was recycled for another page.
+    return false;
+  }
+
+  // Publish the dirty bit before the pin is dropped, so an evictor that claims the frame sees it.
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+
+  // A caller holding a pin brings the count from at least 1, so one decrement is enough; the load only turns away the
+  // common mistake of unpinning a page twice before it can drive the count below zero.
+  if (page->pin_count_.load() <= 0) {
+    return false;
+  }
+  const int pin_count = page->pin_count_.fetch_sub(1);
+  if (pin_count <= 0) {
+    // Another unpin of a page that was not pinned raced with ours; take the decrement back. An evictor that saw the
+    // count below zero meanwhile left the frame to its last unpin, which this is if it restores the count to zero.
+    if (page->pin_count_.fetch_add(1) == -1) {
+      SyncReplacer(frame_id);
     }
-    frame_id = page_table_[page_id];            //ȡframe_id
-    Page curpage = pages_[frame_id];            //ȡҳ
-    if (curpage.pin_count_ == 0) {              //ҳûǷ0
-        return false;                           //粻û򷵻false
+    return false;
+  }
+  if (pin_count == 1) {
+    available_frames_.fetch_add(1, std::memory_order_relaxed);
+    SyncReplacer(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::TryPinResident(frame_id_t frame_id, page_id_t page_id) {
+  Page *page = &pages_[frame_id];
+  // A frame being evicted or loaded is not pinned; the caller waits for it under latch_.
+  const int pin_count = TryAddPin(frame_id);
+  if (pin_count < 0) {
+    return false;
+  }
+
+  // The page table lookup and the pin are not atomic together, so the frame may have been recycled in between. Our
+  // pin now keeps it from changing again, so checking the page id once is enough.
+  if (page->page_id_ != page_id) {
+    ReleasePin(frame_id);
+    return false;
+  }
+
+  if (pin_count == 0) {
+    SyncReplacer(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::TryPinForFlush(frame_id_t frame_id, page_id_t page_id) {
+  // Like TryPinResident, but the replacer is not told: a write back is not an access, and a frame the replacer picks
+  // meanwhile is handed back to it when the pin is released.
+  Page *page = &pages_[frame_id];
+  if (TryAddPin(frame_id) < 0) {
+    return false;
+  }
+  if (page->page_id_ != page_id) {
+    ReleasePin(frame_id);
+    return false;
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::LockLatch(std::unique_lock<std::mutex> *lock) {
+  if (lock->try_lock()) {
+    return;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  lock->lock();
+  const auto waited = std::chrono::steady_clock::now() - start;
+  stats_.Add(BufferPoolCounter::LATCH_WAIT_NS, std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+}
+
+void BufferPoolManagerInstance::WriteBack(frame_id_t frame_id) {
+  // The caller holds a pin, so the frame keeps its page. The read latch keeps writers out while the image is copied.
+  Page *page = &pages_[frame_id];
+  page->RLatch();
+  if (page->is_dirty_.exchange(false)) {
+    disk_manager_->WritePage(page->page_id_, page->GetData());
+    stats_.Add(BufferPoolCounter::DIRTY_WRITEBACKS);
+  }
+  page->RUnlatch();
+}
+
+void BufferPoolManagerInstance::RunCleaner() {
+  std::unique_lock<std::mutex> lock(cleaner_latch_);
+  while (!stop_cleaner_) {
+    cleaner_cv_.wait_for(lock, CLEANER_INTERVAL);
+    if (stop_cleaner_) {
+      break;
     }
+    lock.unlock();
+    CleanFrames();
+    lock.lock();
+  }
+}
 
-    if (is_dirty) {                             //ûʹùжԸҳ޸
-        curpage.is_dirty_ = true;               //ҳΪҳ
+void BufferPoolManagerInstance::CleanFrames() {
+  // Write back the dirty frames among the next victims, so that evictions find them clean.
+  std::vector<frame_id_t> victims;
+  replacer_->NextVictims(clean_reserve_, &victims);
+  for (const frame_id_t frame_id : victims) {
+    Page *page = &pages_[frame_id];
+    if (!page->IsDirty()) {
+      continue;
     }
+    // Pin without telling the replacer, so the frame keeps its place in the replacement order.
+    int pin_count = 0;
+    if (!page->pin_count_.compare_exchange_strong(pin_count, 1)) {
+      continue;
+    }
+    available_frames_.fetch_sub(1, std::memory_order_relaxed);
+    WriteBack(frame_id);
+    ReleasePin(frame_id);
+  }
+}
 
-    curpage.pin_count_--;                       //ݼҳûpin_count_
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, const PrefetchChain &chain) {
+  frame_id_t frame_id;
+  if (chain.length_ <= 1 && page_table_.Find(page_id, &frame_id)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    if (stop_prefetcher_ || prefetch_queue_.size() >= MAX_QUEUED_PREFETCHES) {
+      return;
+    }
+    if (!prefetch_thread_.joinable()) {
+      prefetch_thread_ = std::thread(&BufferPoolManagerInstance::RunPrefetcher, this);
+      if (GetNumaNode() != FrameArena::NO_NUMA_NODE) {
+        FrameArena::BindThread(&prefetch_thread_, GetNumaNode());
+      }
+    }
+    if (chain.strategy_ != nullptr) {
+      chain.strategy_->BeginPrefetch();
+    }
+    prefetch_queue_.emplace_back(page_id, chain);
+  }
+  prefetch_cv_.notify_one();
+}
 
-    if (curpage.pin_count_ == 0) {              //ڵݼֵ0
-        replacer_->Unpin(frame_id);             //replacer_->UnpinԱʾҳԱ
+void BufferPoolManagerInstance::RunPrefetcher() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return stop_prefetcher_ || !prefetch_queue_.empty(); });
+    if (stop_prefetcher_) {
+      break;
+    }
+    const auto [page_id, chain] = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    lock.unlock();
+
+    // Load the page like any fetch, so a concurrent FetchPage of the same page waits for this read instead of
+    // issuing its own.
+    Page *page = FetchPgStrategyImp(page_id, chain.strategy_);
+    if (page != nullptr) {
+      page_id_t next_page_id = INVALID_PAGE_ID;
+      if (chain.length_ > 1 && chain.next_page_ != nullptr) {
+        uint64_t version;
+        do {
+          version = page->BeginOptimisticRead();
+          next_page_id = chain.next_page_(page);
+        } while (!page->ValidateOptimisticRead(version));
+      }
+      UnpinPgImp(page_id, false);
+      if (next_page_id != INVALID_PAGE_ID) {
+        // The next page may belong to another instance of a parallel BPM, so ask the BPM the chain came from.
+        PrefetchChain next_chain = chain;
+        next_chain.length_--;
+        chain.bpm_->PrefetchPage(next_page_id, next_chain);
+      }
     }
-    return true;                                //True
-}                                   
+    if (chain.strategy_ != nullptr) {
+      chain.strategy_->EndPrefetch();
+    }
+    lock.lock();
+  }
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  std::deque<std::pair<page_id_t, PrefetchChain>> dropped;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    stop_prefetcher_ = true;
+    dropped.swap(prefetch_queue_);
+  }
+  prefetch_cv_.notify_one();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
+  for (const auto &request : dropped) {
+    if (request.second.strategy_ != nullptr) {
+      request.second.strategy_->EndPrefetch();
+    }
+  }
+}
 
-page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+void BufferPoolManagerInstance::SyncReplacer(frame_id_t frame_id) {
+  // Replacers that tolerate stale pins only hear about frames becoming unpinned, and need no latch for that.
+  if (!replacer_->NeedsPins()) {
+    if (pages_[frame_id].pin_count_.load() == 0) {
+      replacer_->Unpin(frame_id);
+    }
+    return;
+  }
+  // Pin counts change without latch_, so two threads can race to tell the replacer about opposite transitions.
+  // Re-reading the pin count under replacer_latch_ makes whichever call runs last leave the replacer consistent.
+  std::lock_guard<std::mutex> lock(replacer_latch_);
+  if (pages_[frame_id].pin_count_.load() == 0) {
+    replacer_->Unpin(frame_id);
+  } else {
+    replacer_->Pin(frame_id);
+  }
+}
+
+int BufferPoolManagerInstance::TryAddPin(frame_id_t frame_id) {
+  std::atomic<int> &pin_count = pages_[frame_id].pin_count_;
+  const int old_pin_count = pin_count.fetch_add(1);
+  if (old_pin_count >= 0 && old_pin_count < MAX_PIN_COUNT) {
+    if (old_pin_count == 0) {
+      available_frames_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return old_pin_count;
+  }
+  // Back off. If the frame's owner unlocked it with no pins meanwhile, taking the increment back is the frame's last
+  // unpin, and the replacer has to hear about it.
+  if (pin_count.fetch_sub(1) == 1) {
+    SyncReplacer(frame_id);
+  }
+  return -1;
+}
+
+void BufferPoolManagerInstance::UnlockFrame(frame_id_t frame_id, int pin_count) {
+  pages_[frame_id].pin_count_.fetch_add(pin_count - FRAME_LOCKED, std::memory_order_release);
+}
+
+void BufferPoolManagerInstance::ReleasePin(frame_id_t frame_id) {
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    available_frames_.fetch_add(1, std::memory_order_relaxed);
+    SyncReplacer(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::ReleaseExtentImp(DiskExtent *extent) {
+  disk_manager_->GetSpaceManager()->ReleaseExtent(extent);
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage(DiskExtent *extent) {
+  // A freed page can still be resident if a stale prefetch loaded it again; it must not get a second frame.
+  const auto usable = [this](page_id_t page_id) {
+    frame_id_t frame_id;
+    return router_.InstanceOf(page_id) == instance_index_ && !page_table_.Find(page_id, &frame_id);
+  };
+  DiskSpaceManager *space_manager = disk_manager_->GetSpaceManager();
+  const page_id_t page_id = extent != nullptr && use_extents_ ? space_manager->AllocatePage(extent, usable)
+                                                               : space_manager->AllocatePage(usable);
+  ValidatePageId(page_id);
+  return page_id;
 }
 
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
-  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
-                                                        //ҳ޸ĻشBPI
+  assert(router_.InstanceOf(page_id) == instance_index_);  // allocated pages route back to this BPI
+                                                           //ҳ޸ĻشBPI
 }
 
 }  // namespace bustub
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace bustub {
+
+auto LatencyHistogram::BucketOf(uint64_t value) -> size_t {
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+  const uint32_t exponent = 63 - __builtin_clzll(value);
+  if (exponent >= MAX_EXPONENT) {
+    return NUM_BUCKETS - 1;
+  }
+  // The bits right below the highest one pick the sub-bucket.
+  const uint32_t shift = exponent - SUB_BUCKET_BITS;
+  const size_t sub_bucket = (value >> shift) & (SUB_BUCKETS - 1);
+  return (shift + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+auto LatencyHistogram::BucketLowerBound(size_t bucket) -> uint64_t {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  const size_t shift = bucket / SUB_BUCKETS - 1;
+  return (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+auto LatencyHistogram::BucketUpperBound(size_t bucket) -> uint64_t {
+  return bucket + 1 == NUM_BUCKETS ? UINT64_MAX : BucketLowerBound(bucket + 1) - 1;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    counts_[i] += other.counts_[i];
+  }
+}
+
+auto LatencyHistogram::Count() const -> uint64_t {
+  uint64_t count = 0;
+  for (const uint64_t bucket_count : counts_) {
+    count += bucket_count;
+  }
+  return count;
+}
+
+auto LatencyHistogram::Percentile(double quantile) const -> uint64_t {
+  const uint64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+  // The rank of the quantile among the recorded values, counting from 1.
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return BucketUpperBound(i);
+    }
+  }
+  return BucketUpperBound(NUM_BUCKETS - 1);
+}
+
+void BufferPoolStats::Merge(const BufferPoolStats &other) {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  compressed_hits_ += other.compressed_hits_;
+  evictions_ += other.evictions_;
+  dirty_writebacks_ += other.dirty_writebacks_;
+  dirty_write_stalls_ += other.dirty_write_stalls_;
+  pin_failures_ += other.pin_failures_;
+  latch_wait_ns_ += other.latch_wait_ns_;
+  fetch_latency_.Merge(other.fetch_latency_);
+}
+
+auto BufferPoolStats::HitRatio() const -> double {
+  const uint64_t fetches = hits_ + misses_;
+  return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+}
+
+auto BufferPoolStats::ToJson() const -> std::string {
+  std::ostringstream json;
+  json << "{\"hits\":" << hits_ << ",\"misses\":" << misses_ << ",\"hit_ratio\":" << HitRatio()
+       << ",\"compressed_hits\":" << compressed_hits_ << ",\"evictions\":" << evictions_
+       << ",\"dirty_writebacks\":" << dirty_writebacks_ << ",\"dirty_write_stalls\":" << dirty_write_stalls_
+       << ",\"pin_failures\":" << pin_failures_ << ",\"latch_wait_ns\":" << latch_wait_ns_
+       << ",\"fetch_latency_ns\":{\"samples\":" << fetch_latency_.Count()
+       << ",\"p50\":" << fetch_latency_.Percentile(0.5) << ",\"p90\":" << fetch_latency_.Percentile(0.9)
+       << ",\"p99\":" << fetch_latency_.Percentile(0.99) << ",\"p999\":" << fetch_latency_.Percentile(0.999)
+       << ",\"max\":" << fetch_latency_.Percentile(1) << "}}";
+  return json.str();
+}
+
+thread_local uint32_t BufferPoolStatsRecorder::FetchTimer::sample_counter = 0;
+
+auto BufferPoolStatsRecorder::ThreadShard() -> size_t {
+  // Threads take the shards round robin as they first count something, so up to NUM_SHARDS threads never share one.
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+  return shard;
+}
+
+auto BufferPoolStatsRecorder::Snapshot() const -> BufferPoolStats {
+  std::array<uint64_t, static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS)> counters{};
+  BufferPoolStats stats;
+  for (const Shard &shard : shards_) {
+    for (size_t i = 0; i < counters.size(); i++) {
+      counters[i] += shard.counters_[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+      const uint64_t count = shard.fetch_latency_[i].load(std::memory_order_relaxed);
+      if (count != 0) {
+        stats.fetch_latency_.SetBucketCount(i, stats.fetch_latency_.BucketCount(i) + count);
+      }
+    }
+  }
+  stats.hits_ = counters[static_cast<size_t>(BufferPoolCounter::HITS)];
+  stats.misses_ = counters[static_cast<size_t>(BufferPoolCounter::MISSES)];
+  stats.compressed_hits_ = counters[static_cast<size_t>(BufferPoolCounter::COMPRESSED_HITS)];
+  stats.evictions_ = counters[static_cast<size_t>(BufferPoolCounter::EVICTIONS)];
+  stats.dirty_writebacks_ = counters[static_cast<size_t>(BufferPoolCounter::DIRTY_WRITEBACKS)];
+  stats.dirty_write_stalls_ = counters[static_cast<size_t>(BufferPoolCounter::DIRTY_WRITE_STALLS)];
+  stats.pin_failures_ = counters[static_cast<size_t>(BufferPoolCounter::PIN_FAILURES)];
+  stats.latch_wait_ns_ = counters[static_cast<size_t>(BufferPoolCounter::LATCH_WAIT_NS)];
+  return stats;
+}
+
+}  // namespace bustub
@@ -12,18 +12,79 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_frames_(num_pages), states_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
+  // A sweep clears the reference bits it passes, so the hand finds a victim within two sweeps unless frames are
+  // referenced again meanwhile.
+  while (size_.load() > 0) {
+    const frame_id_t candidate = AdvanceHand();
+    std::atomic<uint8_t> &state = states_[candidate];
+    uint8_t current = state.load();
+    if ((current & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      // Second chance. If the CAS fails, the frame was pinned or referenced meanwhile and is not a victim anyway.
+      state.compare_exchange_strong(current, static_cast<uint8_t>(current & ~REFERENCED));
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0)) {
+      size_--;
+      *frame_id = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "frame id out of range");
+  if ((states_[frame_id].fetch_and(static_cast<uint8_t>(~EVICTABLE)) & EVICTABLE) != 0) {
+    size_--;
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "frame id out of range");
+  if ((states_[frame_id].fetch_or(EVICTABLE | REFERENCED) & EVICTABLE) == 0) {
+    size_++;
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "frame id out of range");
+  if ((states_[frame_id].exchange(0) & EVICTABLE) != 0) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+auto ClockReplacer::Size() -> size_t { return size_.load(); }
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  // Frames the hand will take in its current sweep come first, then those that only lose their reference bit in it.
+  const size_t hand = hand_.load();
+  for (const uint8_t wanted : {EVICTABLE, static_cast<uint8_t>(EVICTABLE | REFERENCED)}) {
+    for (size_t i = 0; i < num_frames_ && frame_ids->size() < max_frames; i++) {
+      const auto frame_id = static_cast<frame_id_t>((hand + i) % num_frames_);
+      if (states_[frame_id].load() == wanted) {
+        frame_ids->push_back(frame_id);
+      }
+    }
+  }
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::AdvanceHand() -> frame_id_t {
+  size_t hand = hand_.load();
+  while (!hand_.compare_exchange_weak(hand, (hand + 1) % num_frames_)) {
+  }
+  return static_cast<frame_id_t>(hand);
+}
 
 }  // namespace bustub
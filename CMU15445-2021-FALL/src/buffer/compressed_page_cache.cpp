@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstring>
+#include <utility>
+
+#include "buffer/page_compressor.h"
+
+namespace bustub {
+
+auto CompressedPageCache::Insert(page_id_t page_id, const char *data) -> bool {
+  const uint64_t ticket = Reserve(page_id);
+  const size_t size = PageCompressor::Compress(data, PAGE_SIZE, scratch_.data(), scratch_.size());
+  return Insert(page_id, ticket, scratch_.data(), size);
+}
+
+auto CompressedPageCache::Reserve(page_id_t page_id) -> uint64_t {
+  Erase(page_id);
+  reservations_[page_id] = next_ticket_;
+  return next_ticket_++;
+}
+
+auto CompressedPageCache::Insert(page_id_t page_id, uint64_t ticket, const char *compressed, size_t size) -> bool {
+  auto reservation = reservations_.find(page_id);
+  if (reservation == reservations_.end() || reservation->second != ticket) {
+    return false;
+  }
+  reservations_.erase(reservation);
+  if (size == 0 || size > MAX_COMPRESSED_SIZE || size > capacity_) {
+    return false;
+  }
+  while (size_ + size > capacity_) {
+    EraseEntry(entries_.find(insertion_order_.front()));
+  }
+  Entry entry{std::make_unique<char[]>(size), size, insertion_order_.insert(insertion_order_.end(), page_id)};
+  memcpy(entry.data_.get(), compressed, size);
+  entries_.emplace(page_id, std::move(entry));
+  size_ += size;
+  return true;
+}
+
+auto CompressedPageCache::Take(page_id_t page_id, char *data) -> bool {
+  reservations_.erase(page_id);
+  auto entry = entries_.find(page_id);
+  if (entry == entries_.end()) {
+    return false;
+  }
+  const bool decompressed = PageCompressor::Decompress(entry->second.data_.get(), entry->second.size_, data, PAGE_SIZE);
+  BUSTUB_ASSERT(decompressed, "a cached page must decompress to a whole page");
+  EraseEntry(entry);
+  return decompressed;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  reservations_.erase(page_id);
+  auto entry = entries_.find(page_id);
+  if (entry != entries_.end()) {
+    EraseEntry(entry);
+  }
+}
+
+void CompressedPageCache::EraseEntry(std::unordered_map<page_id_t, Entry>::iterator entry) {
+  size_ -= entry->second.size_;
+  insertion_order_.erase(entry->second.position_);
+  entries_.erase(entry);
+}
+
+}  // namespace bustub
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+auto RoundUp(size_t size, size_t unit) -> size_t { return (size + unit - 1) / unit * unit; }
+
+/** Parse a list of CPU or node ids as the kernel prints it in sysfs, e.g. "0-3,8,10-11". */
+auto ParseIdList(const std::string &path) -> std::vector<int> {
+  std::vector<int> ids;
+  std::ifstream file(path);
+  std::string list;
+  if (!std::getline(file, list)) {
+    return ids;
+  }
+  std::stringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int id = first; id <= last; id++) {
+      ids.push_back(id);
+    }
+  }
+  return ids;
+}
+}  // namespace
+
+FrameArena::FrameArena(size_t size, int numa_node, bool huge_pages) {
+  const bool huge = huge_pages && size >= HUGE_PAGE_SIZE;
+  void *memory = MAP_FAILED;
+  if (huge) {
+    mapped_size_ = RoundUp(size, HUGE_PAGE_SIZE);
+    memory = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      backing_ = FrameBacking::HUGETLB;
+    }
+  }
+  if (memory == MAP_FAILED && huge) {
+    // Transparent huge pages only back aligned 2 MB ranges, so map one huge page more and trim to the alignment.
+    const size_t padded_size = mapped_size_ + HUGE_PAGE_SIZE;
+    memory = mmap(nullptr, padded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+      auto *start = static_cast<char *>(memory);
+      auto *aligned = reinterpret_cast<char *>(RoundUp(reinterpret_cast<uintptr_t>(start), HUGE_PAGE_SIZE));
+      if (aligned != start) {
+        munmap(start, aligned - start);
+      }
+      munmap(aligned + mapped_size_, start + padded_size - (aligned + mapped_size_));
+      memory = aligned;
+      if (madvise(memory, mapped_size_, MADV_HUGEPAGE) == 0) {
+        backing_ = FrameBacking::TRANSPARENT_HUGE_PAGES;
+      }
+    }
+  }
+  if (memory == MAP_FAILED && !huge) {
+    mapped_size_ = RoundUp(std::max<size_t>(size, 1), static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    memory = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (memory == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map buffer pool frames");
+  }
+  data_ = static_cast<char *>(memory);
+
+  // Nothing has been touched yet, so the policy decides where every page of the arena is allocated.
+  if (numa_node >= 0 && numa_node < static_cast<int>(sizeof(uint64_t) * 8)) {
+    const uint64_t node_mask = uint64_t{1} << numa_node;
+    // The kernel ignores the last bit of maxnode, hence the + 1.
+    if (syscall(SYS_mbind, data_, mapped_size_, MPOL_BIND, &node_mask, sizeof(node_mask) * 8 + 1, 0) == 0) {
+      numa_node_ = numa_node;
+    } else {
+      LOG_DEBUG("can't bind buffer pool frames to NUMA node %d", numa_node);
+    }
+  }
+}
+
+FrameArena::~FrameArena() { munmap(data_, mapped_size_); }
+
+void FrameArena::Release(char *begin, size_t length) {
+  const size_t unit =
+      backing_ == FrameBacking::HUGETLB ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t first = RoundUp(reinterpret_cast<uintptr_t>(begin), unit);
+  const uintptr_t last = (reinterpret_cast<uintptr_t>(begin) + length) / unit * unit;
+  if (first < last && madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED) != 0) {
+    LOG_DEBUG("can't release buffer pool frames");
+  }
+}
+
+auto FrameArena::NumaNodeCount() -> int {
+  const std::vector<int> nodes = ParseIdList("/sys/devices/system/node/online");
+  return nodes.empty() ? 1 : *std::max_element(nodes.begin(), nodes.end()) + 1;
+}
+
+auto FrameArena::BindThread(std::thread *thread, int numa_node) -> bool {
+  const std::vector<int> cpus = ParseIdList("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  if (CPU_COUNT(&cpu_set) == 0) {
+    return false;
+  }
+  return pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+}  // namespace bustub
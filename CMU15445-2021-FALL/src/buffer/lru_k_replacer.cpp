@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to track at least one access per frame");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  // Frames with an infinite backward k-distance go first.
+  auto &list = history_list_.empty() ? cache_list_ : history_list_;
+  if (list.empty()) {
+    return false;
+  }
+  *frame_id = list.begin()->second;
+  Reset(*frame_id);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  FrameInfo &info = frames_[frame_id];
+  if (info.evictable_) {
+    ListOf(info).erase({info.history_.front(), frame_id});
+    info.evictable_ = false;
+  }
+  RecordAccess(&info);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  FrameInfo &info = frames_[frame_id];
+  if (info.evictable_) {
+    return;
+  }
+  if (info.history_.empty()) {
+    // Unpinned without ever being pinned: treat it as accessed now.
+    RecordAccess(&info);
+  }
+  info.evictable_ = true;
+  ListOf(info).insert({info.history_.front(), frame_id});
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return history_list_.size() + cache_list_.size();
+}
+
+void LRUKReplacer::NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(latch_);
+  for (const auto *list : {&history_list_, &cache_list_}) {
+    for (auto it = list->begin(); it != list->end() && frame_ids->size() < max_frames; ++it) {
+      frame_ids->push_back(it->second);
+    }
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  Reset(frame_id);
+}
+
+void LRUKReplacer::RecordAccess(FrameInfo *info) {
+  info->history_.push_back(current_timestamp_++);
+  if (info->history_.size() > k_) {
+    info->history_.pop_front();
+  }
+}
+
+void LRUKReplacer::Reset(frame_id_t frame_id) {
+  FrameInfo &info = frames_[frame_id];
+  if (info.evictable_) {
+    ListOf(info).erase({info.history_.front(), frame_id});
+    info.evictable_ = false;
+  }
+  info.history_.clear();
+}
+
+}  // namespace bustub
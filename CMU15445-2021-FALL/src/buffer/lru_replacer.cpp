@@ -24,7 +24,7 @@
 namespace bustub {
 
 // 캯
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : lru_list_(num_pages) {}
 
 // 
  LRUReplacer::~LRUReplacer() = default;
@@ -32,19 +32,16 @@ LRUReplacer::LRUReplacer(size_t num_pages) {}
 
  /*
  - жǷΪ
- - 粻Ϊ򷵻׽ڵҳID
- - ڹϣнָ׽ڵӳ
+ - 粻Ϊ򷵻βڵҳIDƳ
  */
  bool LRUReplacer::Victim(frame_id_t *frame_id) { 
 
     std::lock_guard<std::mutex> lock(data_latch_);
-   if (lru_list_.empty()) {
+   if (lru_list_.Empty()) {
       return false;
    }
-   
-   *frame_id = lru_list_.back();
-   lru_list_.pop_back();
-   data_idx_.erase(*frame_id);
+
+   *frame_id = lru_list_.PopBack();
    return true;
  }
 
@@ -52,40 +49,41 @@ LRUReplacer::LRUReplacer(size_t num_pages) {}
 * `Pin`
  - `LRUReplace`ǷڶӦҳIDĽڵ㣬
  - 粻ֱӷأ
- - ڶӦڵͨϣд洢ĵɾڵ㣬ϣӦҳIDӳ䡣
+ - ڶӦڵɾڵ㡣ڵҳIDΪ±Уϣ
  */
  void LRUReplacer::Pin(frame_id_t frame_id) { 
    std::lock_guard<std::mutex> lock(data_latch_);   //
-   auto it = data_idx_.find(frame_id);              //ѰǷڶӦҳIDڵ
-   if (it == data_idx_.end()) {                     //
-      return;                                       //ֱӷ
-   }                                                //
-   lru_list_.erase(it->second);                     //ͨϣ洢ĵɾڵ
-   data_idx_.erase(it);                             //ϣӦҳIDӳ
+   lru_list_.Remove(frame_id);                      //ڣɾڵ
  }
 
 /*
 * `Unpin`
  - `LRUReplace`ǷڶӦҳIDĽڵ㣬
  - ֱӷأ
- - 粻βҳIDĽڵ㣬ڹϣв<ҳID - βڵ>ӳ䡣
+ - 粻ײҳIDĽڵ㡣
  */
  void LRUReplacer::Unpin(frame_id_t frame_id) { 
      std::lock_guard<std::mutex> lock(data_latch_); //
-     auto it = data_idx_.find(frame_id);            //ѰǷڶӦҳIDĽڵ
-     if (it != data_idx_.end()) {                   //ڣȡ̶
+     if (lru_list_.Contains(frame_id)) {            //ڣȡ̶
         return;                                     //ֱӷ
      }                                              //
-     lru_list_.emplace_front(frame_id);             //ײҳIDڵ
-     data_idx_[frame_id] = lru_list_.front();       //ڹϣв<ҳID - βڵ>ӳ
+     lru_list_.PushFront(frame_id);                 //ײҳIDڵ
  }
 
 size_t LRUReplacer::Size() { 
     std::lock_guard<std::mutex> lock(data_latch_);  //
-    size_t ret = data_idx_.size();                  //ȡϣС
+    size_t ret = lru_list_.Size();                  //ȡС
     return ret;                                     //ؽ
 }
 
+void LRUReplacer::NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(data_latch_);
+  frame_id_t frame_id = lru_list_.Empty() ? FrameList::INVALID_FRAME : lru_list_.Back();
+  for (; frame_id != FrameList::INVALID_FRAME && frame_ids->size() < max_frames; frame_id = lru_list_.Prev(frame_id)) {
+    frame_ids->push_back(frame_id);
+  }
+}
+
 }  // namespace bustub
 
 /*
@@ -0,0 +1,225 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.cpp
+//
+// Identification: src/buffer/page_compressor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+constexpr uint32_t HASH_BITS = 12;
+/** Length values of a token nibble that are continued in extra bytes. */
+constexpr size_t RUN_MASK = 15;
+/** After 2^SKIP_SHIFT bytes without a match, the compressor checks every other position, and so on. */
+constexpr size_t SKIP_SHIFT = 6;
+/**
+ * Short literal runs and matches are copied in one fixed-size block of this many bytes when the buffers have room for
+ * it; the bytes written past the end are overwritten by the next sequence.
+ */
+constexpr size_t WILD_COPY = 16;
+
+inline auto Read32(const char *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline auto Read64(const char *p) -> uint64_t {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/**
+ * Copy a match of length bytes starting offset bytes back. The match may overlap the bytes it produces, e.g. a run of
+ * one repeated byte has offset 1, so only an offset of at least 8 allows copying 8 bytes at a time.
+ */
+inline void CopyMatch(char *out, const char *out_end, size_t offset, size_t length) {
+  const char *match = out - offset;
+  if (length <= WILD_COPY && offset >= WILD_COPY && static_cast<size_t>(out_end - out) >= WILD_COPY) {
+    memcpy(out, match, WILD_COPY);
+  } else if (offset == 1) {
+    memset(out, *match, length);
+  } else if (offset >= length) {
+    memcpy(out, match, length);
+  } else if (offset >= sizeof(uint64_t)) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+      memcpy(out + i, match + i, sizeof(uint64_t));
+    }
+    for (; i < length; i++) {
+      out[i] = match[i];
+    }
+  } else {
+    for (size_t i = 0; i < length; i++) {
+      out[i] = match[i];
+    }
+  }
+}
+
+/** Append the bytes that continue a length past its token nibble; false if dst is full. */
+inline auto WriteLength(size_t length, char **dst, const char *dst_end) -> bool {
+  for (; length >= 255; length -= 255) {
+    if (*dst == dst_end) {
+      return false;
+    }
+    *(*dst)++ = static_cast<char>(255);
+  }
+  if (*dst == dst_end) {
+    return false;
+  }
+  *(*dst)++ = static_cast<char>(length);
+  return true;
+}
+
+/** Add the bytes that continue a length past its token nibble; false if src ends first. */
+inline auto ReadLength(size_t *length, const char **src, const char *src_end) -> bool {
+  uint8_t byte;
+  do {
+    if (*src == src_end) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(*(*src)++);
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Append a sequence: literals, then a match unless match_length is 0. */
+auto WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length, char **dst,
+                   const char *dst_end) -> bool {
+  if (*dst == dst_end) {
+    return false;
+  }
+  char *token = (*dst)++;
+  const size_t match_code = match_length == 0 ? 0 : match_length - PageCompressor::MIN_MATCH;
+  *token = static_cast<char>((std::min(literal_length, RUN_MASK) << 4) | std::min(match_code, RUN_MASK));
+  if (literal_length >= RUN_MASK && !WriteLength(literal_length - RUN_MASK, dst, dst_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(dst_end - *dst) < literal_length) {
+    return false;
+  }
+  memcpy(*dst, literals, literal_length);
+  *dst += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (dst_end - *dst < 2) {
+    return false;
+  }
+  *(*dst)++ = static_cast<char>(offset & 0xFF);
+  *(*dst)++ = static_cast<char>(offset >> 8);
+  return match_code < RUN_MASK || WriteLength(match_code - RUN_MASK, dst, dst_end);
+}
+}  // namespace
+
+auto PageCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t {
+  BUSTUB_ASSERT(src_size <= MAX_OFFSET + 1, "PageCompressor compresses at most 64 KB at a time");
+  // Position + 1 of the last occurrence of every hashed 4-byte sequence, 0 if none.
+  std::array<uint16_t, 1U << HASH_BITS> last_seen{};
+  char *out = dst;
+  const char *dst_end = dst + dst_capacity;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= src_size) {
+    const uint32_t sequence = Read32(src + pos);
+    const uint32_t hash = Hash(sequence);
+    const size_t candidate = last_seen[hash];
+    last_seen[hash] = static_cast<uint16_t>(pos + 1);
+    if (candidate == 0 || Read32(src + candidate - 1) != sequence) {
+      // Step faster the longer nothing matched, so data that does not compress is skipped over quickly.
+      pos += 1 + ((pos - anchor) >> SKIP_SHIFT);
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (pos + length + sizeof(uint64_t) <= src_size) {
+      const uint64_t diff = Read64(src + match + length) ^ Read64(src + pos + length);
+      if (diff != 0) {
+        length += __builtin_ctzll(diff) / 8;
+        break;
+      }
+      length += sizeof(uint64_t);
+    }
+    if (pos + length + sizeof(uint64_t) > src_size) {
+      while (pos + length < src_size && src[match + length] == src[pos + length]) {
+        length++;
+      }
+    }
+    if (!WriteSequence(src + anchor, pos - anchor, pos - match, length, &out, dst_end)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!WriteSequence(src + anchor, src_size - anchor, 0, 0, &out, dst_end)) {
+    return 0;
+  }
+  return out - dst;
+}
+
+auto PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool {
+  const char *src_end = src + src_size;
+  char *out = dst;
+  char *dst_end = dst + dst_size;
+  while (src < src_end) {
+    const auto token = static_cast<uint8_t>(*src++);
+    size_t literal_length = token >> 4;
+    if (literal_length == RUN_MASK && !ReadLength(&literal_length, &src, src_end)) {
+      return false;
+    }
+    if (static_cast<size_t>(src_end - src) < literal_length || static_cast<size_t>(dst_end - out) < literal_length) {
+      return false;
+    }
+    if (literal_length <= WILD_COPY && static_cast<size_t>(src_end - src) >= WILD_COPY &&
+        static_cast<size_t>(dst_end - out) >= WILD_COPY) {
+      memcpy(out, src, WILD_COPY);
+    } else {
+      memcpy(out, src, literal_length);
+    }
+    out += literal_length;
+    src += literal_length;
+    if (src == src_end) {
+      // The last sequence has no match.
+      break;
+    }
+
+    if (src_end - src < 2) {
+      return false;
+    }
+    const size_t offset = static_cast<uint8_t>(src[0]) | static_cast<size_t>(static_cast<uint8_t>(src[1])) << 8;
+    src += 2;
+    size_t match_length = token & RUN_MASK;
+    if (match_length == RUN_MASK && !ReadLength(&match_length, &src, src_end)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(out - dst) ||
+        static_cast<size_t>(dst_end - out) < match_length) {
+      return false;
+    }
+    CopyMatch(out, dst_end, offset, match_length);
+    out += match_length;
+  }
+  return out == dst_end;
+}
+
+}  // namespace bustub
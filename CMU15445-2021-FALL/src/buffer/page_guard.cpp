@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/buffer/page_guard.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_guard.h"
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept : bpm_(that.bpm_), page_(that.page_) {
+  that.page_ = nullptr;
+}
+
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    that.page_ = nullptr;
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  const page_id_t page_id = page_->GetPageId();
+  page_->RUnlatch();
+  bpm_->UnpinPage(page_id, false);
+  page_ = nullptr;
+}
+
+WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+}
+
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.page_ = nullptr;
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  const page_id_t page_id = page_->GetPageId();
+  page_->WUnlatch();
+  bpm_->UnpinPage(page_id, is_dirty_);
+  page_ = nullptr;
+}
+
+}  // namespace bustub
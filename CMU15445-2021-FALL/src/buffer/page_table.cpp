@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) : capacity_(8), shift_(29) {
+  // Keep the load factor (live entries plus tombstones) at or below 3/4 so that every probe ends on an empty slot.
+  while (capacity_ < num_frames * 2) {
+    capacity_ <<= 1;
+    shift_--;
+  }
+  slots_ = std::make_unique<std::atomic<slot_t>[]>(capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+  while (true) {
+    const uint64_t version = version_.load(std::memory_order_acquire);
+    if ((version & 1) != 0) {
+      // A compaction is moving entries around; wait for it to finish.
+      std::this_thread::yield();
+      continue;
+    }
+
+    bool found = false;
+    frame_id_t result = -1;
+    size_t idx = Home(page_id);
+    for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & (capacity_ - 1)) {
+      const slot_t slot = slots_[idx].load(std::memory_order_acquire);
+      if (slot == EMPTY_SLOT) {
+        break;
+      }
+      if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+        found = true;
+        result = SlotFrameId(slot);
+        break;
+      }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (version_.load(std::memory_order_relaxed) == version) {
+      if (found) {
+        *frame_id = result;
+      }
+      return found;
+    }
+  }
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  size_t idx = Home(page_id);
+  while (true) {
+    const slot_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT || slot == TOMBSTONE_SLOT) {
+      if (slot == TOMBSTONE_SLOT) {
+        tombstones_--;
+      }
+      slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+      size_++;
+      break;
+    }
+    BUSTUB_ASSERT(SlotPageId(slot) != page_id, "page is already in the page table");
+    idx = (idx + 1) & (capacity_ - 1);
+  }
+  if ((size_ + tombstones_) * 4 > capacity_ * 3) {
+    Compact();
+  }
+}
+
+auto PageTable::Erase(page_id_t page_id) -> bool {
+  size_t idx = Home(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & (capacity_ - 1)) {
+    const slot_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+      // Leave a tombstone rather than shifting later entries back, so concurrent readers never miss an entry.
+      slots_[idx].store(TOMBSTONE_SLOT, std::memory_order_release);
+      size_--;
+      tombstones_++;
+      if ((size_ + tombstones_) * 4 > capacity_ * 3) {
+        Compact();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Compact() {
+  std::vector<slot_t> live;
+  live.reserve(size_);
+  for (size_t i = 0; i < capacity_; i++) {
+    const slot_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) {
+      live.push_back(slot);
+    }
+  }
+
+  const uint64_t version = version_.load(std::memory_order_relaxed);
+  version_.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+  for (const slot_t slot : live) {
+    size_t idx = Home(SlotPageId(slot));
+    while (slots_[idx].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+      idx = (idx + 1) & (capacity_ - 1);
+    }
+    slots_[idx].store(slot, std::memory_order_relaxed);
+  }
+  tombstones_ = 0;
+
+  version_.store(version + 2, std::memory_order_release);
+}
+
+}  // namespace bustub
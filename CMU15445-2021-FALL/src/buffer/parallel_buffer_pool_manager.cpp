@@ -18,23 +18,34 @@
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager) {
+                                                     LogManager *log_manager, PageRouting routing,
+                                                     uint32_t extent_size, bool numa_aware, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
+    : router_(routing, num_instances, extent_size) {
   // Allocate and create individual BufferPoolManagerInstances
   num_instances_ = num_instances;
   pool_size_ = pool_size;
   start_idx_ = 0;
   // resizeԺڲȫʼΪ0push_backǴ0ʼֱӵnum_instances + 1
   //instances_.resize(num_instances);  
+  const int num_nodes = FrameArena::NumaNodeCount();
   for (size_t i = 0; i < num_instances; i++) {
+    const int numa_node = numa_aware ? static_cast<int>(i % num_nodes) : FrameArena::NO_NUMA_NODE;
       //ָ
     //instances_[i] = std::make_shared<BufferPoolManagerInstance>(pool_size, num_instances, i, disk_manager, log_manager);
-    BufferPoolManager *tmp = new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager);
+    BufferPoolManager *tmp =
+        new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager, 0, ReplacerType::LRU, 2,
+                                      routing, extent_size, numa_node, max_pool_size, compressed_cache_size);
     instances_.push_back(tmp);
   }
 }
 
 // Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
 ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // A prefetcher may still be handing the next page of a chain to another instance; stop them all before deleting any.
+  for (size_t i = 0; i < num_instances_; i++) {
+    static_cast<BufferPoolManagerInstance *>(instances_[i])->StopPrefetcher();
+  }
   for (size_t i = 0; i < num_instances_; i++) {
     delete (instances_[i]);
   }
@@ -43,14 +54,43 @@ ParallelBufferPoolManager::~ParallelBufferPoolManager() {
 //GetPoolSizeӦȫصظԻ
 size_t ParallelBufferPoolManager::GetPoolSize() {
   // Get size of all BufferPoolManagerInstances  ȡBufferPoolManagerʵĴС
-  return num_instances_ * pool_size_;  // ظ * 
+  // Instances are resized one at a time, so while Resize() runs they may differ in size.
+  size_t pool_size = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    pool_size += instances_[i]->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t new_size) {
+  if (new_size < num_instances_) {
+    return false;
+  }
+  bool resized = true;
+  for (size_t i = 0; i < num_instances_; i++) {
+    const size_t instance_size = new_size / num_instances_ + (i < new_size % num_instances_ ? 1 : 0);
+    resized = instances_[i]->Resize(instance_size) && resized;
+  }
+  return resized;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (size_t i = 0; i < num_instances_; i++) {
+    stats.Merge(instances_[i]->GetStats());
+  }
+  return stats;
+}
+
+int ParallelBufferPoolManager::GetNumaNode(page_id_t page_id) {
+  return static_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(page_id))->GetNumaNode();
 }
 
 //GetBufferPoolManagerҳIDӦĶָ룬ͨҳIDȡķʽҳIDӳӦĻء
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   // BufferPoolManagerҳidʹô˷
-  return instances_[page_id % num_instances_];
+  return instances_[router_.InstanceOf(page_id)];
 }
 
 
@@ -62,6 +102,15 @@ Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
   return instance->FetchPage(page_id);
 }
 
+Page *ParallelBufferPoolManager::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // The strategy keeps a separate ring for every instance the scan reads from.
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, const PrefetchChain &chain) {
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id, chain);
+}
+
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   // Unpin page_id from responsible BufferPoolManagerInstance
   //ӸBufferPoolManagerInstanceȡ̶page_id
@@ -86,9 +135,12 @@ bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
 void ParallelBufferPoolManager::FlushAllPgsImp() {
   // flush all pages from all BufferPoolManagerInstances
   // ˢBufferPoolManagerʵеҳ
+  // Adjacent pages may live in different instances, so flush them all as one batch to let their writes coalesce.
+  std::vector<BufferPoolManagerInstance *> instances;
   for (size_t i = 0; i < num_instances_; i++) {
-    instances_[i]->FlushAllPages();
+    instances.push_back(static_cast<BufferPoolManagerInstance *>(instances_[i]));
   }
+  BufferPoolManagerInstance::FlushDirtyPages(instances);
 }
 
 // öӦصķɡֵעǣڻдŵΪʵĻָ룬
@@ -113,18 +165,44 @@ void ParallelBufferPoolManager::FlushAllPgsImp() {
   //        1ɹȻ󷵻
   //        2ѭʼnullptr
   //  2.   ÿεô˺ʱʼmodʵڲͬBPMIʼ
-Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) { return NewPgExtentImp(page_id, nullptr); }
+
+Page *ParallelBufferPoolManager::NewPgExtentImp(page_id_t *page_id, DiskExtent *extent) {
+    // The rest of an extent belongs to one instance; only when it cannot create the page does another one start a new
+    // extent. The extent is read without the space manager's latch, which is fine for a hint.
+    if (extent != nullptr) {
+        const page_id_t next_page_id = extent->next_page_id_;
+        if (next_page_id != INVALID_PAGE_ID && next_page_id < extent->end_page_id_) {
+            Page *ret = GetBufferPoolManager(next_page_id)->NewPageInExtent(page_id, extent);
+            if (ret != nullptr) {
+                return ret;
+            }
+        }
+    }
+    // Instances without a free or unpinned frame are skipped by their counter alone, so a nearly full pool does not
+    // cost a latch acquisition per instance. The counter is only a hint: an instance may still fail, then move on.
+    const size_t start_idx = start_idx_.load(std::memory_order_relaxed);
     Page *ret;
     for (size_t i = 0; i < num_instances_; i++) {
-        size_t idx = (start_idx_ + i) % num_instances_;
-        if ((ret = instances_[idx]->NewPage()(page_id)) != nullptr) {   //ҳɹ
-            start_idx_ = (*page_id + 1) % num_instances_;               //һοʼΪҳһ
+        size_t idx = (start_idx + i) % num_instances_;
+        if (static_cast<BufferPoolManagerInstance *>(instances_[idx])->GetAvailableFrames() == 0) {
+            continue;
+        }
+        ret = extent == nullptr ? instances_[idx]->NewPage(page_id) : instances_[idx]->NewPageInExtent(page_id, extent);
+        if (ret != nullptr) {   //ҳɹ
+            //һοʼΪҳһ
+            start_idx_.store(router_.InstanceOf(*page_id + 1), std::memory_order_relaxed);
             return ret;                                                 //شҳ
         }
     }
-    start_idx_++;   //Ȼûдɹʼ+1ԭʼλ
+    start_idx_.fetch_add(1, std::memory_order_relaxed);   //Ȼûдɹʼ+1ԭʼλ
     return nullptr; //nullptr
 }
 
+void ParallelBufferPoolManager::ReleaseExtentImp(DiskExtent *extent) {
+    // All instances share the disk manager, so any of them can give the extent back.
+    instances_[0]->ReleaseExtent(extent);
+}
+
 
 }  // namespace bustub
@@ -47,6 +47,8 @@ void TransactionManager::Commit(Transaction *txn) {
     if (item.wtype_ == WType::DELETE) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::BULK_INSERT) {
+      table->CommitBulkInsert(item.rid_, txn);
     }
     write_set->pop_back();
   }
@@ -72,6 +74,8 @@ void TransactionManager::Abort(Transaction *txn) {
       table->ApplyDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::UPDATE) {
       table->UpdateTuple(item.tuple_, item.rid_, txn);
+    } else if (item.wtype_ == WType::BULK_INSERT) {
+      table->RollbackBulkInsert(item.rid_, txn);
     }
     table_write_set->pop_back();
   }
@@ -36,20 +36,19 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
   // LOG_DEBUG("BUCKET_ARRAY_SIZE = %ld", BUCKET_ARRAY_SIZE);
 
     //Ŀ¼ҳ棬ǿתȫdata_,ӰԪ
-    HashTableDirectoryPage *dir_page =              //Ŀ¼ҳΪĿ¼ҳpage_id
-      reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&directory_page_id_));
+    WritePageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_, &extent_);  //Ŀ¼ҳΪĿ¼ҳpage_id
+    BUSTUB_ASSERT(dir_guard.IsValid(), "Couldn't create the directory page of the hash table.");
+    auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
     dir_page->SetPageId(directory_page_id_);        //Ŀ¼ҳID
 
     //Ͱҳ
     page_id_t new_bucket_id;
-    buffer_pool_manager->NewPage(&new_bucket_id);   // һͰҳ
+    WritePageGuard bucket_guard = buffer_pool_manager_->NewPageGuarded(&new_bucket_id, &extent_);   // һͰҳ
+    BUSTUB_ASSERT(bucket_guard.IsValid(), "Couldn't create the first bucket page of the hash table.");
 
     dir_page->SetBucketPageId(0, new_bucket_id);    //Ŀ¼ҳbucket_page_ids_(bucket_idx, bucket_page_id)
 
-    //UnpinPage򻺳ظ֪ҳʹ
-  //auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));  //ȡ̶Ϊҳ
-  assert(buffer_pool_manager_->UnpinPage(new_bucket_id, true, nullptr));
+    // Both pages are unpinned dirty when their guards go out of scope.
 }
 
 /*****************************************************************************
@@ -85,18 +84,18 @@ page_id_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_
 
 // ӻعȡĿ¼ҳ
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_));
+ReadPageGuard HASH_TABLE_TYPE::FetchDirectoryPage() {
+  return buffer_pool_manager_->FetchPageRead(directory_page_id_);
 }
 
 // ʹô洢Ͱpage_idӻعлȡ洢Ͱҳ档
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id));
+ReadPageGuard HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
+  return buffer_pool_manager_->FetchPageRead(bucket_page_id);
 }
 
 ///////////////////////////////////////
-//  ÿFetchʱҳڶᱻΪPinҪעҪUnPinr
+//  Fetch pins the page; the guard it returns unpins it again when it is dropped or goes out of scope.
 
 
 /*****************************************************************************
@@ -104,26 +103,47 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 /*
     GetValueӹϣжȡƥֵͨϣĶĿ¼ҳ棬
-    ʹͰĶͰҳ档ĲΪ
+    Ŀ¼ҳͰҳ̶ֻҳֹ۵ضȡ(дصʱض)ĲΪ
     1.ȶȡĿ¼ҳ棬
     2.ͨĿ¼ҳ͹ϣӦͰҳ棬
     3.ͰҳGetValueȡֵ
     ںʱעҪUnpinPageȡҳ档ʱӦ֤Ļȡͷȫ˳Ա
 */
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {  
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();                      //Ŀ¼ҳ
+bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   table_latch_.RLock();                                                         //ϱΪĿ¼ҳ
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);                        //ͰID
-  HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);             //Ͱҳ
-  Page *p = reinterpret_cast<Page *>(bucket);                                   //ͰҳǿתΪPage
-  p->RLatch();                                                                  //Ͱҳ϶(ҳ)
-  bool ret = bucket->GetValue(key, comparator_, result);                        //ȡӦֵresultУTrue
-  p->RUnlatch();                                                                //Ͱҳ(ҳ)
+  // Lookups only pin the pages and read them optimistically, so they do not contend for the page latches; a read
+  // that overlaps a writer is done again.
+  Page *dir_page = buffer_pool_manager_->FetchPage(directory_page_id_);         //Ŀ¼ҳ
+  if (dir_page == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  page_id_t bucket_page_id;
+  uint64_t version;
+  do {
+    version = dir_page->BeginOptimisticRead();
+    bucket_page_id = KeyToPageId(key, PageAs<HashTableDirectoryPage>(dir_page));  //ͰID
+  } while (!dir_page->ValidateOptimisticRead(version));
+  // The table latch keeps the bucket from being split or merged, the directory page is no longer needed.
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  Page *bucket_page = buffer_pool_manager_->FetchPage(bucket_page_id);           //Ͱҳ
+  bool ret = false;
+  if (bucket_page != nullptr) {
+    const size_t num_results = result->size();
+    while (true) {
+      version = bucket_page->BeginOptimisticRead();
+      //ȡӦֵresult
+      ret = PageAs<HASH_TABLE_BUCKET_TYPE>(bucket_page)->GetValue(key, comparator_, result);
+      if (bucket_page->ValidateOptimisticRead(version)) {
+        break;
+      }
+      // Whatever the overlapping read found may be torn.
+      result->erase(result->begin() + num_results, result->end());
+    }
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);                     //ȡ̶Ͱҳ
+  }
   table_latch_.RUnlock();                                                       //
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));  //ȡ̶
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
-
   return ret;
 }
 
@@ -143,29 +163,34 @@ Insert
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-    HashTableDirectoryPage *dir_page = FetchDirectoryPage();                    //ȡĿ¼ҳ
     table_latch_.RLock();                                                       //Ŀ¼ҳ϶
-    page_id_t bucket_page_id = KeyToPageId(key, dir_page);                      //ͨĿ¼ҳϻõͰҳöӦͰҳͰID
-    HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);           //ȡͰҳ
-    Page *p = reinterpret_cast<Page *>(bucket);                                 //ΪͰҳǿת
-    p->WLatch();                                                                //Ͱҳд
-    if (bucket->IsFull) {                                                       //ͰҪ
-        p->WUnlatch();                                                          //Ͱҳд
+    ReadPageGuard dir_guard = FetchDirectoryPage();                             //ȡĿ¼ҳ
+    if (!dir_guard.IsValid()) {
+        table_latch_.RUnlock();
+        return false;
+    }
+    page_id_t bucket_page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());  //ͨĿ¼ͰID
+    dir_guard.Drop();
+    WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);   //ȡͰҳ沢д
+    if (!bucket_guard.IsValid()) {
+        table_latch_.RUnlock();
+        return false;
+    }
+    auto *bucket = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+    if (bucket->IsFull()) {                                                     //ͰҪ
+        bucket_guard.Drop();                                                    //Ͱҳдȡ̶
         table_latch_.RUnlock();                                                 //Ŀ¼ҳ
-        assert(buffer_pool_manager_->UnpinPage(bucket, true, nullptr));         //Ͱҳȡ̶Ϊҳ
-        assert(buffer_pool_manager_->UnpinPage(dir_page, true, nullptr));       //Ŀ¼ҳȡ̶Ϊҳ
         return SplitInsert(transaction, key, value);                            //÷Ѳ뺯
     }
     bool ret = bucket->Insert(key, value, comparator_);                         //ͰѣֱӲֵ
-    p->WUnlatch();                                                              //Ͱҳд
+    if (ret) {
+        bucket_guard.MarkDirty();
+    }
+    bucket_guard.Drop();                                                        //Ͱҳд
     table_latch_.RUnlock();                                                     //
-    assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr)); //Ŀ¼ҳȡ̶
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));     //Ͱҳȡ̶
     return ret;
 }
 
-
-
 /*
 *ʹÿѡͰִв롣ҳڷָȻģȻݹָ
 *Ϊпܡ
@@ -180,92 +205,114 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
 */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-    HashTableDirectoryPage *dir_page = FetchBucketPage();                                                   // »ȡĿ¼ҳ
     table_latch_.WLock();
+    WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);                 // »ȡĿ¼ҳ
+    if (!dir_guard.IsValid()) {
+        table_latch_.WUnlock();
+        return false;
+    }
+    auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
     while (true) {
-        uint32_t bucket_idx = KeyToDirectoryIndex(ket, dir_page);                                           //ȡĿ¼
+        uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);                                           //ȡĿ¼
         page_id_t bucket_page_id = KeyToPageId(key, dir_page);                                              //ͨĿ¼ȡͰҳID
-        HASH_TABLE_BUCKET_TYPE *bucket = FetchDirectoryPage(bucket_page_id);                                //ȡͰҳID
-
-        if (bucket->IsFull) {                                                                               //Ͱģ
-            uint32_t global_depth = dir_page->GetGlobalDepth();                                             //ȡȫ
-            uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);                                     //ȡҪͰľֲ
-            page_id_t new_bucket_id = 0;
-            HASH_TABLE_BUCKET_TYPE *new_bucket =                                                            //ȡһҳŷѺͰ
-                reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&new_bucket_id));
-            assert(new_bucket != nullptr);
-
-            if (global_depth == local_depth) {                                                              //ֲȵȫȣĿ¼
-                uint32_t bucket_num = 1 << global_depth;                                                    //ȡͰ
-                for (uint32_t i = 0; i < bucket_num; i++) {                                                 
-                    dir_page->SetBucketPageId(i + bucket_num, dir_page->GetBucketPageId(i));                //÷Ŀ¼ҳ
-                    dir_page->SetLocalDepth(i + bucket_num, dir_page->GetLocalDepth(i));                    //÷Ŀ¼Ͱľֲ
-                }
-                dir_page->IncrGlobalDepth();                                                                //Ѻȫȼһ
-                dir_page->SetBucketPageId(bucket_idx + bucket_num, new_bucket_id);                          //¹ϣָķͰ
-                dir_page->IncrLocalDepth(bucket_idx);                                                       //ԭͰֲ
-                dir_page->IncrLocalDepth(bucket_idx + bucket_num);                                          //ӷͰֲ
-                global_depth++;                                                                             //ȫȼһ
-            } else {                //ֲСȫȣͰĿ¼
-                /*  i = GD, j = LD
-                   ֵĿ¼еˣλʾСĿ¼Ϊjλ䡢λΪ0Ŀ¼
-                   Ŀ¼Ĺϣ    step = 1<<j
-                   ѺֵĿ¼Ĺϣ step*2
-                   ֵĿ¼Ϊ1<<(i - j)
-                   ҪĵΪ 1<<(i - j - 1)
-                */
-                // ˴Ϊold_maskΪ111  new_maskΪ1111
-                uint32_t mask = (1 << local_depth) - 1;     // 2^1 - 1 = 1 -> 0001
-
-              // ʼID
-                // 0111 & 1111 = 0111ΪǰͰIDbase_idx
-                uint32_t base_idx = mask & bucket_idx;
-
-                // ҪĵGD=2, LD=1 recordes_num = 1; GD=3, LD=2 recordes_num = 1; GD=3, LD=1 recordes_num = 2
-                uint32_t records_num = 1 << (global_depth - local_depth - 1);  // 2 ^ (2 - 1 - 1)
-
-                //  LD = 1step = 2;  LD = 2step = 4
-                uint32_t step = (1 << local_depth);  // 2^local_depth
-                uint32_t idx = base_idx;
-
-                // ȱһĿ¼ָͰλȼһ
-                for (uint32_t i = 0; i < records_num; i++) {
-                    dir_page->IncrLocalDepth(idx);  // Ŀ¼ӦԭͰֲȼһ
-                    idx += step * 2;
-                }
-
-                // ǷӰȫȣԸλýв
-                idx = base_idx + step;
-                for (uint32_t i = 0; i < records_num; i++) {  // Ŀ¼ֲȼһĿ¼ָͰȼһ
-                    dir_page->SetBucketPageId(idx, new_bucket_id);
-                    dir_page->IncrLocalDepth(idx);
-                    idx += step * 2;
-                }
-            }
-            /*
-                ͰѺӦԭͰҳеļ¼²ϣڼ¼ĵi-1λԭͰҳͰҳӦ
-                ˼¼ͰҳΪԭͰҳͰҳѡ²¼ͷͰҳԭͰҳ档
-            */
-            for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-                KeyType j_key = bucket->KeyAt(i);                                   //ȡͰڲ۵Ĺϣ
-                ValueType j_value = bucket->ValueAt(i);                             //ȡ۵ֵ
-                bucket->RemoveAt(i);                                                //ɾͰڲ۵ļֵ
-                if (KeyToPageId(j_key, dir_page) == bucket_page_id) {               //ϣԭͰ
-                    bucket->Insert(j_key, j_value, comparator_);                    //ԭͰ
-                } else {                                                            //ϣڷͰ
-                    new_bucket->Insert(j_key, j_value, comparator_);                //Ͱ
-                }
-            }
-            assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));  // ԭͰҳȡȷ
-            assert(buffer_pool_manager_->UnpinPage(new_bucket_id, true, nullptr));   // Ͱҳȡ̶
-        } else {
+        WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);                 //ȡͰҳ
+        if (!bucket_guard.IsValid()) {
+            break;
+        }
+        auto *bucket = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+
+        if (!bucket->IsFull()) {
             bool ret = bucket->Insert(key, value, comparator_);                         // ֱӲ
+            if (ret) {
+                bucket_guard.MarkDirty();
+            }
+            bucket_guard.Drop();                                                        // Ͱҳȡ̶
+            dir_guard.Drop();                                                           // Ŀ¼ҳȡ̶
             table_latch_.WUnlock();                                                     // Ŀ¼ҳд
-            assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr)); // Ŀ¼ҳȡ̶
-            assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));     // Ͱҳȡ̶
             return ret;
         }
+
+        //Ͱģ
+        uint32_t global_depth = dir_page->GetGlobalDepth();                                             //ȡȫ
+        uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);                                     //ȡҪͰľֲ
+        if (global_depth == local_depth && dir_page->Size() * 2 > DIRECTORY_ARRAY_SIZE) {
+            // The directory can't grow any further, e.g. because the bucket only holds values of a single key.
+            break;
+        }
+        page_id_t new_bucket_id = 0;
+        WritePageGuard new_bucket_guard = buffer_pool_manager_->NewPageGuarded(&new_bucket_id, &extent_);          //ȡһҳŷѺͰ
+        if (!new_bucket_guard.IsValid()) {
+            break;
+        }
+        auto *new_bucket = new_bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+        dir_guard.MarkDirty();
+        bucket_guard.MarkDirty();
+
+        if (global_depth == local_depth) {                                                              //ֲȵȫȣĿ¼
+            uint32_t bucket_num = 1 << global_depth;                                                    //ȡͰ
+            for (uint32_t i = 0; i < bucket_num; i++) {
+                dir_page->SetBucketPageId(i + bucket_num, dir_page->GetBucketPageId(i));                //÷Ŀ¼ҳ
+                dir_page->SetLocalDepth(i + bucket_num, dir_page->GetLocalDepth(i));                    //÷Ŀ¼Ͱľֲ
+            }
+            dir_page->IncrGlobalDepth();                                                                //Ѻȫȼһ
+            dir_page->SetBucketPageId(bucket_idx + bucket_num, new_bucket_id);                          //¹ϣָķͰ
+            dir_page->IncrLocalDepth(bucket_idx);                                                       //ԭͰֲ
+            dir_page->IncrLocalDepth(bucket_idx + bucket_num);                                          //ӷͰֲ
+            global_depth++;                                                                             //ȫȼһ
+        } else {                //ֲСȫȣͰĿ¼
+            /*  i = GD, j = LD
+               ֵĿ¼еˣλʾСĿ¼Ϊjλ䡢λΪ0Ŀ¼
+               Ŀ¼Ĺϣ    step = 1<<j
+               ѺֵĿ¼Ĺϣ step*2
+               ֵĿ¼Ϊ1<<(i - j)
+               ҪĵΪ 1<<(i - j - 1)
+            */
+            // ˴Ϊold_maskΪ111  new_maskΪ1111
+            uint32_t mask = (1 << local_depth) - 1;     // 2^1 - 1 = 1 -> 0001
+
+            // ʼID
+            // 0111 & 1111 = 0111ΪǰͰIDbase_idx
+            uint32_t base_idx = mask & bucket_idx;
+
+            // ҪĵGD=2, LD=1 recordes_num = 1; GD=3, LD=2 recordes_num = 1; GD=3, LD=1 recordes_num = 2
+            uint32_t records_num = 1 << (global_depth - local_depth - 1);  // 2 ^ (2 - 1 - 1)
+
+            //  LD = 1step = 2;  LD = 2step = 4
+            uint32_t step = (1 << local_depth);  // 2^local_depth
+            uint32_t idx = base_idx;
+
+            // ȱһĿ¼ָͰλȼһ
+            for (uint32_t i = 0; i < records_num; i++) {
+                dir_page->IncrLocalDepth(idx);  // Ŀ¼ӦԭͰֲȼһ
+                idx += step * 2;
+            }
+
+            // ǷӰȫȣԸλýв
+            idx = base_idx + step;
+            for (uint32_t i = 0; i < records_num; i++) {  // Ŀ¼ֲȼһĿ¼ָͰȼһ
+                dir_page->SetBucketPageId(idx, new_bucket_id);
+                dir_page->IncrLocalDepth(idx);
+                idx += step * 2;
+            }
+        }
+        /*
+            ͰѺӦԭͰҳеļ¼²ϣڼ¼ĵi-1λԭͰҳͰҳӦ
+            ˼¼ͰҳΪԭͰҳͰҳѡ²¼ͷͰҳԭͰҳ档
+        */
+        for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+            KeyType j_key = bucket->KeyAt(i);                                   //ȡͰڲ۵Ĺϣ
+            ValueType j_value = bucket->ValueAt(i);                             //ȡ۵ֵ
+            bucket->RemoveAt(i);                                                //ɾͰڲ۵ļֵ
+            if (KeyToPageId(j_key, dir_page) == bucket_page_id) {               //ϣԭͰ
+                bucket->Insert(j_key, j_value, comparator_);                    //ԭͰ
+            } else {                                                            //ϣڷͰ
+                new_bucket->Insert(j_key, j_value, comparator_);                //Ͱ
+            }
+        }
+        // Both buckets are unpinned when their guards go out of scope.
     }
+    dir_guard.Drop();
+    table_latch_.WUnlock();
     return false;
 }
 
@@ -280,30 +327,33 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-    
-}
-
-
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();                      //Ŀ¼ҳ
   table_latch_.RLock();                                                         //϶
+  ReadPageGuard dir_guard = FetchDirectoryPage();                               //Ŀ¼ҳ
+  if (!dir_guard.IsValid()) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
   uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);                     //Ŀ¼ҳͰҳ
   page_id_t bucket_page_id = KeyToPageId(key, dir_page);                        //Ŀ¼ҳͰҳID
-  HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);             //Ͱҳ
-  Page *p = reinterpret_cast<Page *>(bucket);
-  p->WLatch();
+  uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+  dir_guard.Drop();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);  //Ͱҳ
+  if (!bucket_guard.IsValid()) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  auto *bucket = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
   bool ret = bucket->Remove(key, value, comparator_);                           //ɾӦֵ
-  p->WUnlatch();
-  if (bucket->IsEmpty() && dir_page->GetLocalDepth(bucket_idx) != 0) {          //ͰɾΪҾֲȲΪ0
-    table_latch_.RUnlock();                                                     //
+  if (ret) {
+    bucket_guard.MarkDirty();
+  }
+  bool is_empty = bucket->IsEmpty();
+  bucket_guard.Drop();                                                          //Ͱҳȡ̶
+  table_latch_.RUnlock();                                                       //
+  if (ret && is_empty && local_depth != 0) {                                    //ͰɾΪҾֲȲΪ0
     this->Merge(transaction, key, value);                                       //ϲ
-  } else {                                                                      //ͰΪգֱӽ
-    table_latch_.RUnlock();                                         
   }
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));       //Ͱҳȡ̶,Ϊҳ
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));   //Ŀ¼ҳȡ̶,Ϊҳ
   return ret;
 }
 
@@ -315,47 +365,69 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();                                          //Ŀ¼ҳ     
   table_latch_.WLock();                                                                             //д
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);                                 //Ŀ¼ҳȡͰ
-  HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);                                 //±ɾֵԵͰҳ
-  if (bucket->IsEmpty() && dir_page->GetLocalDepth(bucket_idx) != 0) {                              //ͰΪҾֲȲΪ0
+  WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);              //Ŀ¼ҳ
+  if (!dir_guard.IsValid()) {
+    table_latch_.WUnlock();
+    return;
+  }
+  auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);                                         //ȡĿ¼
+  std::vector<page_id_t> deleted_page_ids;
+  while (true) {
     uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);                                     //ȡֲ
-    uint32_t global_depth = dir_page->GetGlobalDepth();                                             //ȡȫ
+    if (local_depth == 0) {
+      break;
+    }
     // ҵҪϲbucket
     // 𣺺ϲָMerged Bucketļ¼
     // ͬĵͣlocal_depth-1λ
     // ˣתlocal_depthԻҪϲbucketidx
-    uint32_t merged_bucket_idx = bucket_idx ^ (1 << (local_depth - 1));                             //ȡĿ¼ֵͰ
+    uint32_t merged_bucket_idx = dir_page->GetSplitImageIndex(bucket_idx);                          //ȡĿ¼ֵͰ
+    if (dir_page->GetLocalDepth(merged_bucket_idx) != local_depth) {                                //ֵͰֲȲͬ򲻺ϲ
+      break;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);                               //Ŀ¼ҳȡͰҳID
     page_id_t merged_page_id = dir_page->GetBucketPageId(merged_bucket_idx);                        //ȡҪϲbucketҳID
-    HASH_TABLE_BUCKET_TYPE *merged_bucket = FetchBucketPage(merged_page_id);                        //ȡµҪϲbucketҳ
-    if (dir_page->GetLocalDepth(merged_bucket_idx) == local_depth && merged_bucket->IsEmpty()) {    //ϲBucketҳֲȵɾBucketҳľֲȣΪͰ
-      local_depth--;     //ֲ-1ΪǰӰĿ¼бľֲ
-      // ˴Ϊȥ룬111ԭΪ1111
-      uint32_t mask = (1 << local_depth) - 1;  
-      // 0111 & 1111 = 0111
-      uint32_t idx = mask & bucket_idx;
-      // ֵĿ¼Ϊ1 << (i - j)
-      uint32_t records_num = 1 << (global_depth - local_depth);
-      // Ŀ¼Ĺϣ step = 1 << j 
-      // ѺֵĿ¼Ĺϣ step * 2
-      uint32_t step = (1 << local_depth);
-
-      for (uint32_t i = 0; i < records_num; i++) {                  //
-        dir_page->SetBucketPageId(idx, bucket_page_id);             //Ŀ¼ҳҳIDΪһ
-        dir_page->DecrLocalDepth(idx);
-        idx += step;
-      }
-      buffer_pool_manager_->DeletePage(merged_page_id);             //ɾϲҳ
+    // Fold whichever of the two buckets is empty into the other one.
+    page_id_t empty_page_id;
+    page_id_t kept_page_id;
+    if (IsBucketEmpty(bucket_page_id)) {
+      empty_page_id = bucket_page_id;
+      kept_page_id = merged_page_id;
+    } else if (IsBucketEmpty(merged_page_id)) {
+      empty_page_id = merged_page_id;
+      kept_page_id = bucket_page_id;
+    } else {
+      break;
     }
-    if (dir_page->CanShrink()) {        //жĿ¼ҳǷ
-      dir_page->DecrGlobalDepth();
+
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      page_id_t page_id = dir_page->GetBucketPageId(i);
+      if (page_id == bucket_page_id || page_id == merged_page_id) {
+        dir_page->SetBucketPageId(i, kept_page_id);                                                 //Ŀ¼ҳҳIDΪһ
+        dir_page->DecrLocalDepth(i);
+      }
     }
-    assert(buffer_pool_manager_->UnpinPage(merged_page_id, true, nullptr));     //ϲҳȡȷ
+    deleted_page_ids.push_back(empty_page_id);
+    dir_guard.MarkDirty();
+    // The merged bucket may in turn be empty, or have an empty split image, now that its local depth is lower.
+  }
+  while (dir_page->CanShrink()) {        //жĿ¼ҳǷ
+    dir_page->DecrGlobalDepth();
+    dir_guard.MarkDirty();
+  }
+  dir_guard.Drop();                                                                                 //Ŀ¼ҳȡ̶
+  for (page_id_t page_id : deleted_page_ids) {
+    buffer_pool_manager_->DeletePage(page_id);                                                      //ɾϲҳ
   }
-  table_latch_.WUnlock();                                                       //
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));   //Ŀ¼ҳȡ̶
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));       //ɾҳȡ̶
+  table_latch_.WUnlock();                                                                           //д
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::IsBucketEmpty(page_id_t bucket_page_id) {
+  ReadPageGuard bucket_guard = FetchBucketPage(bucket_page_id);
+  return bucket_guard.IsValid() && bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsEmpty();
 }
 
 /*****************************************************************************
@@ -364,9 +436,9 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  ReadPageGuard dir_guard = FetchDirectoryPage();
+  uint32_t global_depth = dir_guard.As<HashTableDirectoryPage>()->GetGlobalDepth();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -377,9 +449,9 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  ReadPageGuard dir_guard = FetchDirectoryPage();
+  dir_guard.As<HashTableDirectoryPage>()->VerifyIntegrity();
+  dir_guard.Drop();
   table_latch_.RUnlock();
 }
 
@@ -63,34 +63,16 @@ bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *outp
     return true;
 }
 
-void SeqScanExecutor::Init() { 
-    table_oid_t oid = plan_->GetTableOid();                             //planлȡoid
-    table_info_ = exec_ctx_->GetCatalog()->GetTable(oid);               //ͨoidȡӦ
-    iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());    //ȡʼ
-    end_ = table_info_->table_->End();                                  //ȡ
-
-    auto output_schema = plan_->OutputSchema();                         //ȡģʽ
-    auto table_schema = table_info_->schema_;                           //ȡģʽ
-    is_same_schema_ = SchemaEqual(&table_schema, output_schema);        //жǷͬ
-
-    // ظԪ϶ύٽ
-    auto transaction = exec_ctx_->GetTransaction();                             //
-    auto lockmanager = exec_ctx_->GetLockManager();                             //
-    if (transaction->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ) {  //뼶Ϊظ
-        auto iter = table_info_->table_->Begin(exec_ctx_->GetTransaction());    //ÿԪ鶼϶
-        while (iter != table_info_->table_->End()) {
-            lockmanager->LockShared(transaction, iter->GetRid());
-            ++iter;
-        }
-    }
-}
-
-
 //Init()Уִмƻڵĳʼ趨ĵʹòѯƻ±
 void SeqScanExecutor::Init() {
   table_oid_t oid = plan_->GetTableOid();                // Ӧɨıʶ
   table_info_ = exec_ctx_->GetCatalog()->GetTable(oid);  // OIDѯԪ
-  iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());  // table_ָѵӵָ  transaction ִĹ
+  // A scan reads every page of the table once; keep it from pushing the rest of the buffer pool out.
+  strategy_.reset();
+  if (exec_ctx_->GetScanRingSize() > 0) {
+    strategy_ = std::make_unique<BufferAccessStrategy>(exec_ctx_->GetScanRingSize());
+  }
+  iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction(), strategy_.get());  // table_ָѵӵָ  transaction ִĹ
   end_ = table_info_->table_->End();
 
   auto output_schema = plan_->OutputSchema();                   //ģʽ
@@ -101,7 +83,7 @@ void SeqScanExecutor::Init() {
   auto transaction = exec_ctx_->GetTransaction();
   auto lockmanager = exec_ctx_->GetLockManager();
   if (transaction->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ) {
-    auto iter = table_info_->table_->Begin(exec_ctx_->GetTransaction());
+    auto iter = table_info_->table_->Begin(exec_ctx_->GetTransaction(), strategy_.get());
     while (iter != table_info_->table_->End()) {
       lockmanager->LockShared(transaction, iter->GetRid());
       ++iter;
@@ -115,45 +97,6 @@ void SeqScanExecutor::Init() {
 //out_schemaģʽ顣bustubУвѯƻڵԪͨout_schemaиColumn
 //ColumnValueExpressionеĸ֡Evaluate죬EvaluateEvaluateJoin
 //EvaluateAggregate
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { 
-    
-    const AbstractExpression *predicate = plan_->GetPredicate();    //ν
-    const Schema *output_schema = plan_->OutputSchema();            //ȡģʽ
-    Schema table_schema = table_info_->schema_;                     //ȡģʽ
-    auto exec_ctx = GetExecutorContext();                           //ȡòִ
-    Transaction *transaction = exec_ctx->GetTransaction();          //ȡ
-    LockManager *lockmanager = exec_ctx->GetLockManager();          //ȡ
-    bool res;
-
-    while (iter_ != end_) {
-        // ύԪʱ϶ͷ
-        if (transaction->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
-          lockmanager->LockShared(transaction, iter_->GetRid());
-        }
-        auto p_tuple = &(*iter);    // ȡָԪָ룻
-        res = true;
-        if (predicate != nullptr) {
-            res = predicate->Evaluate(p_tuple, &table_schema).GetAs<bool>();    //鿴νʹ˺Ƿݴ
-        }                                                                       //ڼڷfalse
-        if (res) {                                  
-            if (!is_same_schema_) {             //ģʽģʽһ,ıԪݽṹ
-                TupleSchemaTranformUseEvaluate(p_tuple, &table_schema, tuple, output_schema);
-            } else {                            //һ£д
-                *tuple = *p_tuple;
-            }
-            *rid = p_tuple->GetRid(); 
-        }
-        if (transaction->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
-            lockmanager->Unlock(transaction, iter_->GetRid());
-        }
-        ++iter_;    /// ָһλúٷ
-        if (res) {
-            return true;
-        }
-    }
-    return false;
-}
-
 bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
 
   //ڲԪνʣֻеԪļΪtrueʱӦԪ
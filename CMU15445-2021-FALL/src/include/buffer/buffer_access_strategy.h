@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BufferAccessStrategy keeps a large sequential scan from flushing the buffer pool.
+ *
+ * Pages a scan has to read from disk are loaded into a small ring of frames that the scan keeps recycling: once the
+ * ring is full, the next miss reuses the frame of the page read ring_size misses ago, as long as nobody else has
+ * pinned or dirtied it since. Otherwise the buffer pool falls back to its regular replacement and the new frame takes
+ * that slot of the ring. Pages that are already resident are used as they are and do not enter the ring.
+ *
+ * A strategy belongs to a single scan, but the buffer pool's prefetcher may load pages through it on the scan's
+ * behalf. It keeps one ring per buffer pool instance it touches, and its destructor waits for outstanding prefetches.
+ */
+class BufferAccessStrategy {
+ public:
+  /** Default number of frames a scan recycles per buffer pool instance. */
+  static constexpr size_t DEFAULT_RING_SIZE = 32;
+
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size number of frames the scan recycles per buffer pool instance
+   */
+  explicit BufferAccessStrategy(size_t ring_size = DEFAULT_RING_SIZE) : ring_size_(ring_size) {
+    BUSTUB_ASSERT(ring_size > 0, "a scan ring needs at least one frame");
+  }
+
+  ~BufferAccessStrategy() {
+    std::unique_lock<std::mutex> lock(latch_);
+    prefetch_cv_.wait(lock, [&] { return pending_prefetches_ == 0; });
+  }
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return number of frames the scan recycles per buffer pool instance */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+  /**
+   * Advance the ring of a buffer pool instance to its next slot.
+   * @param bpm the buffer pool instance loading a page for the scan
+   * @return the slot, holding the page last loaded into it (INVALID_PAGE_ID if none). The buffer pool stores the
+   * page it loads for the scan there. Callers loading pages into the same instance are serialized by its latch.
+   */
+  auto NextSlot(const BufferPoolManager *bpm) -> page_id_t * {
+    std::lock_guard<std::mutex> lock(latch_);
+    Ring *ring = nullptr;
+    for (auto &entry : rings_) {
+      if (entry.first == bpm) {
+        ring = &entry.second;
+        break;
+      }
+    }
+    if (ring == nullptr) {
+      rings_.emplace_back(bpm, Ring{std::vector<page_id_t>(ring_size_, INVALID_PAGE_ID), 0});
+      ring = &rings_.back().second;
+    }
+    page_id_t *slot = &ring->pages_[ring->cursor_];
+    ring->cursor_ = (ring->cursor_ + 1) % ring_size_;
+    return slot;
+  }
+
+  /** Register a prefetch that will load pages through this strategy. */
+  void BeginPrefetch() {
+    std::lock_guard<std::mutex> lock(latch_);
+    pending_prefetches_++;
+  }
+
+  /** Mark a registered prefetch as done (or dropped). The prefetcher must not touch the strategy afterwards. */
+  void EndPrefetch() {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (--pending_prefetches_ == 0) {
+      prefetch_cv_.notify_all();
+    }
+  }
+
+ private:
+  struct Ring {
+    std::vector<page_id_t> pages_;
+    size_t cursor_;
+  };
+
+  const size_t ring_size_;
+  /** Rings by buffer pool instance; a parallel buffer pool has only a handful of instances. */
+  std::vector<std::pair<const BufferPoolManager *, Ring>> rings_;
+  /** Prefetches that still hold a pointer to this strategy */
+  size_t pending_prefetches_{0};
+  std::condition_variable prefetch_cv_;
+  /** Protects rings_ and pending_prefetches_ */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -16,13 +16,36 @@
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+class BufferPoolManager;
+
+/**
+ * PrefetchChain describes how a prefetch keeps reading ahead along a chain of linked pages, e.g. the pages of a
+ * table heap.
+ */
+struct PrefetchChain {
+  /** Number of pages to load, counting the first one */
+  size_t length_{1};
+  /**
+   * Reads the id of the page that follows a loaded page (INVALID_PAGE_ID at the end of the chain). It runs under an
+   * optimistic read and may be retried, so it must only read, and not past the page.
+   */
+  page_id_t (*next_page_)(Page *page){nullptr};
+  /** Access strategy the pages are loaded through, nullptr to load them as usual */
+  BufferAccessStrategy *strategy_{nullptr};
+  /** Buffer pool the prefetch was requested from; the rest of the chain is requested from it too */
+  BufferPoolManager *bpm_{nullptr};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -45,6 +68,86 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch the requested page on behalf of a large sequential scan. If the page has to be read from disk, it is loaded
+   * into the scan's ring of frames instead of taking a frame from the rest of the pool.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's access strategy
+   * @return the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgStrategyImp(page_id, strategy);
+  }
+
+  /**
+   * Fetch the requested page and read latch it.
+   * @param page_id id of page to be fetched
+   * @return a guard that unlatches and unpins the page, not valid if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch the requested page and write latch it.
+   * @param page_id id of page to be fetched
+   * @return a guard that unlatches and unpins the page, not valid if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Create a new page in the buffer pool, write latched. It is unpinned dirty.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, see NewPageInExtent(); nullptr for any free page
+   * @return a guard that unlatches and unpins the page, not valid if no new page could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, DiskExtent *extent = nullptr) -> WritePageGuard {
+    Page *page = extent == nullptr ? NewPgImp(page_id) : NewPgExtentImp(page_id, extent);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page, true};
+  }
+
+  /**
+   * Create a new page in the buffer pool, next to the caller's other pages where possible: the page is taken from the
+   * caller's extent, and a new extent is reserved when it runs out. Buffer pools that cannot keep an extent together
+   * create the page as NewPage() does.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, e.g. of a table heap or an index; to be given back by ReleaseExtent()
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageInExtent(page_id_t *page_id, DiskExtent *extent) -> Page * { return NewPgExtentImp(page_id, extent); }
+
+  /**
+   * Give back the pages of an extent that were not used.
+   * @param extent the extent
+   */
+  void ReleaseExtent(DiskExtent *extent) { ReleaseExtentImp(extent); }
+
+  /**
+   * Ask the buffer pool to load a page (and the pages after it in a chain) in the background. Returns immediately;
+   * the pages are fetched and unpinned again by the buffer pool, so a later FetchPage is likely to hit.
+   * @param page_id id of the first page to load
+   * @param chain how far to read ahead from the first page
+   */
+  void PrefetchPage(page_id_t page_id, PrefetchChain chain = {}) {
+    if (chain.bpm_ == nullptr) {
+      chain.bpm_ = this;
+    }
+    PrefetchPgImp(page_id, chain);
+  }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -87,6 +190,16 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /**
+   * Change the number of frames of the buffer pool while it is in use.
+   * @param new_size number of frames
+   * @return true if the buffer pool has new_size frames now; buffer pools of a fixed size return false
+   */
+  virtual auto Resize(size_t new_size) -> bool { return false; }
+
+  /** @return the buffer pool's counters so far; buffer pools that keep none return all zeros */
+  virtual auto GetStats() -> BufferPoolStats { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +221,24 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, loading it through the given access strategy on a miss.
+   * Buffer pools without support for access strategies fetch the page as usual.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller
+   * @return the requested page
+   */
+  virtual auto FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id);
+  }
+
+  /**
+   * Load the requested pages in the background. Buffer pools without a prefetcher ignore the request.
+   * @param page_id id of the first page to load
+   * @param chain how far to read ahead from the first page
+   */
+  virtual void PrefetchPgImp(page_id_t page_id, const PrefetchChain &chain) {}
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +261,20 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a new page in the buffer pool, taking it from an extent. Buffer pools without extents create any page.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgExtentImp(page_id_t *page_id, DiskExtent *extent) -> Page * { return NewPgImp(page_id); }
+
+  /**
+   * Gives back the pages of an extent that were not used. Buffer pools without extents ignore the request.
+   * @param extent the extent
+   */
+  virtual void ReleaseExtentImp(DiskExtent *extent) {}
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
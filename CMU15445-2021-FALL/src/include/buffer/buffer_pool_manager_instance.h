@@ -12,12 +12,27 @@
 
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <climits>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/frame_list.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_router.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -29,13 +44,23 @@ namespace bustub {
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
  public:
+  /** A page holds at most this many pins; fetching it again fails rather than let a leaked pin count overflow. */
+  static constexpr int MAX_PIN_COUNT = 1 << 20;
+
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param clean_reserve number of clean frames the background cleaner keeps ready for eviction (0 = no cleaner)
+   * @param replacer_type replacement policy of the buffer pool
+   * @param replacer_k number of accesses tracked per frame by ReplacerType::LRU_K
+   * @param max_pool_size number of frames Resize() can grow the pool to (0 = pool_size)
+   * @param compressed_cache_size bytes of memory for compressed copies of evicted pages (0 = no compressed cache)
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            size_t clean_reserve = 0, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t replacer_k = 2, size_t max_pool_size = 0, size_t compressed_cache_size = 0);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +68,22 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param clean_reserve number of clean frames the background cleaner keeps ready for eviction (0 = no cleaner)
+   * @param replacer_type replacement policy of the buffer pool
+   * @param replacer_k number of accesses tracked per frame by ReplacerType::LRU_K
+   * @param routing how the parallel BPM maps page ids to instances, this BPI only allocates pages routed to it
+   * @param extent_size number of adjacent pages per extent under EXTENT and HASH routing
+   * @param numa_node NUMA node to allocate the frames on and run the background threads on, or NO_NUMA_NODE
+   * @param max_pool_size number of frames Resize() can grow the pool to (0 = pool_size)
+   * @param compressed_cache_size bytes of memory for compressed copies of evicted pages (0 = no compressed cache)
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr, size_t clean_reserve = 0,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t replacer_k = 2,
+                            PageRouting routing = PageRouting::MODULO,
+                            uint32_t extent_size = PageRouter::DEFAULT_EXTENT_SIZE,
+                            int numa_node = FrameArena::NO_NUMA_NODE, size_t max_pool_size = 0,
+                            size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -53,11 +91,56 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   ~BufferPoolManagerInstance() override;
 
   /** @return size of the buffer pool */
-  size_t GetPoolSize() override { return pool_size_; }
+  size_t GetPoolSize() override { return pool_size_.load(std::memory_order_acquire); }
+
+  /** @return number of frames the buffer pool can grow to */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  /**
+   * Change the number of frames while the buffer pool is in use. Frames are added or removed at the end of the frame
+   * array: growing makes reserved frames free, shrinking evicts the pages of the frames removed (writing back dirty
+   * ones) and gives their memory back to the kernel. Frames that stay pinned for RESIZE_DRAIN_TIMEOUT are kept, so a
+   * shrink may stop short of the requested size.
+   * @param new_size number of frames, at most GetMaxPoolSize()
+   * @return true if the buffer pool has new_size frames now
+   */
+  bool Resize(size_t new_size) override;
 
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
+  /** @return the NUMA node the frames live on, or FrameArena::NO_NUMA_NODE if they are not bound to one */
+  int GetNumaNode() const { return frame_arena_.GetNumaNode(); }
+
+  /** @return the kind of virtual memory pages backing the frames */
+  FrameBacking GetFrameBacking() const { return frame_arena_.GetBacking(); }
+
+  /**
+   * @return number of frames that are free or hold an unpinned page, i.e. that NewPage() could use. Read without any
+   * latch, so it is a hint that may be stale by the time the caller acts on it.
+   */
+  size_t GetAvailableFrames() const {
+    return static_cast<size_t>(std::max(0, available_frames_.load(std::memory_order_relaxed)));
+  }
+
+  /** @return the counters of this instance so far */
+  BufferPoolStats GetStats() override { return stats_.Snapshot(); }
+
+  /**
+   * Stop the background prefetcher and drop the prefetches still queued. The destructor calls this; a parallel BPM
+   * calls it on all of its instances before destroying any, because prefetch chains move between instances.
+   */
+  void StopPrefetcher();
+
+  /**
+   * Write back the dirty pages of buffer pool instances that share a disk manager, e.g. all instances of a parallel
+   * BPM. Pages go to DiskManager::WritePages() in batches in page id order, so adjacent pages are coalesced even when
+   * they belong to different instances. No instance latch is held while writing: each page is
+   * pinned, copied under its read latch and marked clean, and stays pinned until its image is on disk.
+   * @param instances the instances to flush
+   */
+  static void FlushDirtyPages(const std::vector<BufferPoolManagerInstance *> &instances);
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +149,21 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool, loading it into the strategy's ring of frames on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr to fetch the page as usual
+   * @return the requested page
+   */
+  Page *FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Queue pages to be loaded by the background prefetcher, which is started on first use.
+   * @param page_id id of the first page to load
+   * @param chain how far to read ahead from the first page
+   */
+  void PrefetchPgImp(page_id_t page_id, const PrefetchChain &chain) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -75,7 +173,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   bool UnpinPgImp(page_id_t page_id, bool is_dirty) override;
 
   /**
-   * Flushes the target page to disk.
+   * Flushes the target page to disk. Takes the page's read latch, so the caller must not hold its write latch.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
@@ -88,6 +186,20 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, taking it from an extent.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgExtentImp(page_id_t *page_id, DiskExtent *extent) override;
+
+  /**
+   * Gives back the pages of an extent that were not used.
+   * @param extent the extent
+   */
+  void ReleaseExtentImp(DiskExtent *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -101,18 +213,18 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Allocate a page on disk: the lowest free page that routes to this BPI and is not resident, or the next page of an
+   * extent. Extents are only used if their pages all route to this BPI.
+   * @param extent the extent of the caller, nullptr for none
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(DiskExtent *extent = nullptr);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, giving its space back to the file system. Its page id can be handed out again.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -123,14 +235,136 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
+  /**
+   * Take a free frame or evict a clean victim. Dirty victims are written back, and evicted pages compressed into the
+   * compressed cache, with latch_ released.
+   * @param lock the caller's hold on latch_, which may be released and re-acquired
+   * @return a frame in the FRAME_LOCKED state, or NUMLL_FRAME if every frame is pinned
+   */
   // 获取页框，进入函数前需加锁
-  frame_id_t GetFrame();
+  frame_id_t GetFrame(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Remove a frame at or past pool_size_ from use: take it off the free list, or evict its page. The caller must hold
+   * latch_, which is released and re-acquired to write back a dirty page or compress the evicted one.
+   * @param frame_id frame to retire
+   * @param lock the caller's hold on latch_
+   * @return false if the frame is pinned
+   */
+  bool RetireFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Put a copy of a clean page that was just evicted into the compressed cache. The page is compressed with latch_
+   * released; its frame is claimed, so nobody changes the page meanwhile.
+   * @param page the evicted page, still in its FRAME_LOCKED frame
+   * @param lock the caller's hold on latch_, which is released and re-acquired
+   */
+  void CompressEvicted(Page *page, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Reclaim the frame of a page a scan loaded earlier. The caller must hold latch_.
+   * @param page_id page last loaded into the scan's ring slot
+   * @return the page's frame in the FRAME_LOCKED state, or NUMLL_FRAME if the page is gone, pinned or dirty
+   */
+  frame_id_t TakeRingFrame(page_id_t page_id);
+
+  /**
+   * Write a dirty page back to disk. The caller must hold a pin on the frame and must not hold latch_.
+   * @param frame_id frame to write back
+   */
+  void WriteBack(frame_id_t frame_id);
+
+  /** Background cleaner loop: wakes up every CLEANER_INTERVAL (or when an evictor hit a dirty victim). */
+  void RunCleaner();
+
+  /** Write back the unpinned dirty frames among the next clean_reserve_ victims. */
+  void CleanFrames();
+
+  /** Background prefetcher loop: loads queued pages and requests the next page of their chain. */
+  void RunPrefetcher();
+
+  /**
+   * Pin a resident page without taking latch_.
+   * @param frame_id frame the page table mapped the page to
+   * @param page_id id of the page expected in the frame
+   * @return true if the page was pinned, false if the frame is being (re)loaded or holds another page by now
+   */
+  bool TryPinResident(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Tell the replacer whether a frame is evictable after its pin count crossed zero.
+   * @param frame_id frame whose pin count changed
+   */
+  void SyncReplacer(frame_id_t frame_id);
+
+  /**
+   * Acquire latch_ for a lock created with std::defer_lock, counting the time spent waiting if it is contended.
+   * @param lock the caller's lock on latch_
+   */
+  void LockLatch(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Pin a resident page for a write back without recording an access in the replacer.
+   * @param frame_id frame the page table mapped the page to
+   * @param page_id id of the page expected in the frame
+   * @return true if the page was pinned; release the pin with ReleasePin()
+   */
+  bool TryPinForFlush(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Add a pin to a frame with a single atomic increment, without latch_. A frame that is FRAME_LOCKED or already holds
+   * MAX_PIN_COUNT pins is left as it was. The caller checks that the frame still holds the page it wants.
+   * @param frame_id frame to pin
+   * @return the pin count before the new pin, or -1 if the frame was not pinned
+   */
+  int TryAddPin(frame_id_t frame_id);
+
+  /**
+   * Move a frame claimed with FRAME_LOCKED to a pin count, keeping the increments of optimistic pins still backing off.
+   * @param frame_id frame claimed by the caller
+   * @param pin_count pin count of the frame from now on
+   */
+  void UnlockFrame(frame_id_t frame_id, int pin_count);
+
+  /**
+   * Drop a pin that was not handed out by FetchPage/NewPage. Releasing the last pin makes the frame available again.
+   * @param frame_id frame of the pinned page
+   */
+  void ReleasePin(frame_id_t frame_id);
 
   static const frame_id_t NUMLL_FRAME = -1;
 
+  /**
+   * Pin count of a frame that is free or being (re)loaded under latch_; optimistic pins back off from it. Optimistic
+   * pins increment the count before they look at it, so it lies far below zero: the count stays negative however many
+   * pins are backing off at once. For the same reason a frame leaves this state through UnlockFrame(), which adds to
+   * the count instead of storing it.
+   */
+  static constexpr int FRAME_LOCKED = INT_MIN / 2;
+
+  /** The prefetch queue never holds more requests than this; further requests are dropped. */
+  static constexpr size_t MAX_QUEUED_PREFETCHES = 64;
+
+  /** FlushDirtyPages() copies and writes at most this many pages at a time. */
+  static constexpr size_t FLUSH_BATCH_PAGES = 256;
+
+  /** A flush batch pins at most 1/FLUSH_PIN_DIVISOR of the frames of an instance, so fetches still find frames. */
+  static constexpr size_t FLUSH_PIN_DIVISOR = 4;
+
+  /** How long a shrinking Resize() waits for the pages of the frames it removes to be unpinned. */
+  static constexpr std::chrono::milliseconds RESIZE_DRAIN_TIMEOUT{500};
+
+  /** How often the cleaner checks the clean frame reserve when nobody wakes it up. */
+  static constexpr std::chrono::milliseconds CLEANER_INTERVAL{10};
+
   /** Number of pages in the buffer pool. */\
   //缓冲池中的页数。
-  const size_t pool_size_;
+  // Frames 0..pool_size_-1 are in use and the rest up to max_pool_size_ are reserved for Resize(). Only changed under
+  // latch_; frames past it may still hold pages while a shrink drains them.
+  std::atomic<size_t> pool_size_;
+
+  /** Number of frames whose memory and book-keeping is reserved. */
+  const size_t max_pool_size_;
 
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   //并行BPM中有多少实例（除非存在，否则只有1个BPI）
@@ -140,9 +374,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   //并行BPM中此BPI的索引（除非存在，否则仅为0）
   const uint32_t instance_index_ = 0;
 
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  //每个BPI都为要分发的page_id维护自己的计数器，必须确保它们变回其instance_index_
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
+  /** Maps page ids to the instance that owns them, the same way the parallel BPM routes requests */
+  const PageRouter router_;
+
+  /** True if the extents of the disk space manager never straddle two instances, so this BPI can use them */
+  const bool use_extents_;
+
+  /** Memory of the frames' data and of pages_, backed by huge pages if the pool is large enough. */
+  FrameArena frame_arena_;
 
   /** Array of buffer pool pages. */
   //pages_为缓冲池中的实际容器页面槽位数组，用于存放从磁盘中读入的页面，并供DBMS访问
@@ -156,9 +395,9 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   //log_manager_为日志管理器，本实验中不用考虑该组件
   LogManager *log_manager_ __attribute__((__unused__));
 
-  /** Page table for keeping track of buffer pool pages. */
+  /** Page table for keeping track of buffer pool pages. Readable without latch_, written only under latch_. */
   //page_table_用于保存磁盘页面IDpage_id和槽位IDframe_id_t的映射
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  PageTable page_table_;
 
   /** Replacer to find unpinned pages for replacement. */
   //raplacer_用于选取所需驱逐的页面
@@ -166,9 +405,43 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   /** List of free pages. */
   //保存缓冲池中的空闲槽位ID
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  FrameList free_list_;
+  /**
+   * Number of frames whose pin count is not positive: free, unpinned or momentarily claimed. Every pin count change
+   * across zero adjusts it, so it may briefly be off by the changes in flight (even negative), but it does not drift.
+   */
+  std::atomic<int> available_frames_;
+  /**
+   * This latch serializes page table writes, the free list and frame (re)assignment. Fetching or unpinning a resident
+   * page does not take it.
+   */
   std::mutex latch_;
+  /** Serializes replacer updates made outside latch_ with the pin counts they are derived from. */
+  std::mutex replacer_latch_;
+
+  /** Compressed copies of evicted clean pages, checked before reading the disk; nullptr if disabled. */
+  std::unique_ptr<CompressedPageCache> compressed_cache_;  // guarded by latch_
+
+  /** Serializes Resize() calls, which release latch_ while they drain frames. */
+  std::mutex resize_latch_;
+
+  /** Hits, misses, evictions etc. of this instance, counted per thread. */
+  BufferPoolStatsRecorder stats_;
+
+  /** Number of clean frames the cleaner tries to keep evictable. */
+  const size_t clean_reserve_;
+  std::thread cleaner_thread_;
+  /** Protects stop_cleaner_ and backs cleaner_cv_. */
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool stop_cleaner_{false};
+
+  std::thread prefetch_thread_;
+  /** Protects prefetch_queue_ and stop_prefetcher_ and backs prefetch_cv_. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<std::pair<page_id_t, PrefetchChain>> prefetch_queue_;
+  bool stop_prefetcher_{false};
 };
 }  // namespace bustub
 //在这里，区分page_id和frame_id_t是完成本实验的关键。
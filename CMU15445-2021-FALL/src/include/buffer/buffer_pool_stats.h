@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * LatencyHistogram counts latencies in log-linear buckets, like an HDR histogram: every power of two is split into
+ * SUB_BUCKETS equal buckets, so any recorded value is known within 1 / SUB_BUCKETS of itself, from nanoseconds to
+ * minutes, in a few hundred counters.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr uint32_t SUB_BUCKET_BITS = 3;
+  static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BUCKET_BITS;
+  /** Values of 2^MAX_EXPONENT ns (about 18 minutes) and more are counted in the last bucket. */
+  static constexpr uint32_t MAX_EXPONENT = 40;
+  static constexpr size_t NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  /** @return the bucket a value is counted in */
+  static auto BucketOf(uint64_t value) -> size_t;
+
+  /** @return the smallest value counted in a bucket */
+  static auto BucketLowerBound(size_t bucket) -> uint64_t;
+
+  /** @return the largest value counted in a bucket */
+  static auto BucketUpperBound(size_t bucket) -> uint64_t;
+
+  /** Count one value. */
+  void Record(uint64_t value) { counts_[BucketOf(value)]++; }
+
+  /** Add the counts of another histogram to this one. */
+  void Merge(const LatencyHistogram &other);
+
+  /** @return number of recorded values */
+  auto Count() const -> uint64_t;
+
+  /**
+   * @param quantile between 0 and 1, e.g. 0.99
+   * @return the largest value of the bucket that holds the quantile, 0 if nothing was recorded
+   */
+  auto Percentile(double quantile) const -> uint64_t;
+
+  /** @return the number of values counted in a bucket */
+  auto BucketCount(size_t bucket) const -> uint64_t { return counts_[bucket]; }
+
+  /** Set the number of values counted in a bucket, e.g. when copying a histogram that is being recorded into. */
+  void SetBucketCount(size_t bucket, uint64_t count) { counts_[bucket] = count; }
+
+ private:
+  std::array<uint64_t, NUM_BUCKETS> counts_{};
+};
+
+/**
+ * BufferPoolStats is a snapshot of the counters of a buffer pool instance, or their sum over the instances of a
+ * parallel buffer pool. The counters only grow, so the difference of two snapshots gives the rates in between.
+ */
+struct BufferPoolStats {
+  /** Fetches of a page that was already resident */
+  uint64_t hits_{0};
+  /** Fetches that read the page from disk */
+  uint64_t misses_{0};
+  /** Fetches of a page that was not resident, served from the compressed page cache instead of the disk */
+  uint64_t compressed_hits_{0};
+  /** Frames taken from another page to load a page */
+  uint64_t evictions_{0};
+  /** Dirty pages written back, by evictions, the cleaner or flushes */
+  uint64_t dirty_writebacks_{0};
+  /** Evictions that had to wait for a dirty victim to be written back */
+  uint64_t dirty_write_stalls_{0};
+  /** Fetches and new pages that failed because every frame was pinned */
+  uint64_t pin_failures_{0};
+  /** Nanoseconds spent waiting for the buffer pool latch on the slow paths of FetchPage and NewPage */
+  uint64_t latch_wait_ns_{0};
+  /** Latency of FetchPage in ns, for a sample of the calls */
+  LatencyHistogram fetch_latency_;
+
+  /** Add the counters of another snapshot to this one. */
+  void Merge(const BufferPoolStats &other);
+
+  /** @return hits / (hits + misses), 0 if nothing was fetched; compressed hits are not counted */
+  auto HitRatio() const -> double;
+
+  /** @return the snapshot as a JSON object, with the fetch latency summarized as percentiles */
+  auto ToJson() const -> std::string;
+};
+
+/** The counters kept by BufferPoolStatsRecorder. */
+enum class BufferPoolCounter {
+  HITS,
+  MISSES,
+  COMPRESSED_HITS,
+  EVICTIONS,
+  DIRTY_WRITEBACKS,
+  DIRTY_WRITE_STALLS,
+  PIN_FAILURES,
+  LATCH_WAIT_NS,
+  NUM_COUNTERS,
+};
+
+/**
+ * BufferPoolStatsRecorder keeps the counters of one buffer pool instance. Every thread counts in one of NUM_SHARDS
+ * shards, each on its own cache lines, so threads that fetch pages concurrently do not contend on the counters;
+ * Snapshot() adds the shards up.
+ */
+class BufferPoolStatsRecorder {
+ public:
+  static constexpr size_t NUM_SHARDS = 16;
+  /** One in this many FetchPage calls of a thread is timed, which keeps the clock off most fetches. */
+  static constexpr uint32_t LATENCY_SAMPLE_PERIOD = 32;
+
+  BufferPoolStatsRecorder() = default;
+
+  DISALLOW_COPY_AND_MOVE(BufferPoolStatsRecorder);
+
+  /** Add to a counter. */
+  void Add(BufferPoolCounter counter, uint64_t n = 1) {
+    GetShard().counters_[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /** @return the counters of all threads so far */
+  auto Snapshot() const -> BufferPoolStats;
+
+  /** Times a FetchPage call, if it is among the sampled ones, from its construction to its destruction. */
+  class FetchTimer {
+   public:
+    explicit FetchTimer(BufferPoolStatsRecorder *recorder) {
+      if (++sample_counter % LATENCY_SAMPLE_PERIOD == 0) {
+        recorder_ = recorder;
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~FetchTimer() {
+      if (recorder_ != nullptr) {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        recorder_->RecordFetchLatency(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+      }
+    }
+
+    DISALLOW_COPY_AND_MOVE(FetchTimer);
+
+   private:
+    static thread_local uint32_t sample_counter;
+    BufferPoolStatsRecorder *recorder_{nullptr};
+    std::chrono::steady_clock::time_point start_;
+  };
+
+ private:
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS)> counters_{};
+    std::array<std::atomic<uint64_t>, LatencyHistogram::NUM_BUCKETS> fetch_latency_{};
+  };
+
+  void RecordFetchLatency(uint64_t ns) {
+    GetShard().fetch_latency_[LatencyHistogram::BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto GetShard() -> Shard & { return shards_[ThreadShard()]; }
+
+  /** @return the shard of the calling thread, the same in every recorder */
+  static auto ThreadShard() -> size_t;
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+}  // namespace bustub
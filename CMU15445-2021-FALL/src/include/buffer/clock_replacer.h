@@ -12,8 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +23,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has an atomic state word holding an evictable bit and a reference bit. Pin and Unpin only flip these
+ * bits and never block. Victim sweeps a single clock hand, advanced with compare-and-swap, over the frames: it gives
+ * referenced frames a second chance by clearing their reference bit and claims the first evictable frame without one.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +49,26 @@ class ClockReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  /** Unpin sets the reference bit even for a frame that is still evictable, so pins need not be reported. */
+  auto NeedsPins() const -> bool override { return false; }
+
  private:
-  // TODO(student): implement me!
+  static constexpr uint8_t EVICTABLE = 1;
+  static constexpr uint8_t REFERENCED = 2;
+
+  /** Move the clock hand forward by one frame. @return the frame the hand was on */
+  auto AdvanceHand() -> frame_id_t;
+
+  const size_t num_frames_;
+  /** EVICTABLE and REFERENCED bits of every frame */
+  std::vector<std::atomic<uint8_t>> states_;
+  std::atomic<size_t> hand_{0};
+  /** Number of frames with the EVICTABLE bit set */
+  std::atomic<size_t> size_{0};
 };
 
 }  // namespace bustub
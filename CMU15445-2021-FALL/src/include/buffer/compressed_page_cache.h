@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a second cache tier below a buffer pool: it keeps compressed copies of pages the buffer pool
+ * evicted, so that fetching them again decompresses a copy instead of reading the disk. It holds at most capacity
+ * bytes of compressed data and drops the least recently inserted pages to make room.
+ *
+ * Only clean pages may be inserted, and the cache is exclusive: a page taken back into the buffer pool leaves the
+ * cache, so a copy can never be older than the page on disk.
+ *
+ * A page can also be compressed outside the owner's latch: Reserve() it under the latch, compress it with
+ * PageCompressor, and Insert() the result under the latch again. Taking or erasing the page in between cancels the
+ * insert, so a copy that went stale meanwhile never gets in.
+ *
+ * CompressedPageCache is not thread-safe; its owner serializes access.
+ */
+class CompressedPageCache {
+ public:
+  /** Pages that do not compress to this size or less are not worth their space and are not cached. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE * 3 / 4;
+
+  /**
+   * Create an empty cache.
+   * @param capacity number of bytes of compressed data the cache may hold
+   */
+  explicit CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * Compress and cache a clean page, replacing an older copy.
+   * @param page_id id of the page
+   * @param data the page's data, PAGE_SIZE bytes
+   * @return false if the page does not compress well enough to be cached
+   */
+  auto Insert(page_id_t page_id, const char *data) -> bool;
+
+  /**
+   * Drop the copy of a page that is about to be compressed, and reserve its insert.
+   * @param page_id id of the page
+   * @return the ticket to pass to Insert()
+   */
+  auto Reserve(page_id_t page_id) -> uint64_t;
+
+  /**
+   * Cache a page compressed by the caller, unless its reservation was cancelled by a Take() or Erase() since.
+   * @param page_id id of the page
+   * @param ticket what Reserve() returned for the page
+   * @param compressed the compressed page
+   * @param size size of the compressed page, 0 if it did not compress
+   * @return false if the page is not cached
+   */
+  auto Insert(page_id_t page_id, uint64_t ticket, const char *compressed, size_t size) -> bool;
+
+  /**
+   * Decompress a cached page and remove it from the cache.
+   * @param page_id id of the page
+   * @param[out] data the page's data, PAGE_SIZE bytes
+   * @return false if the page is not cached
+   */
+  auto Take(page_id_t page_id, char *data) -> bool;
+
+  /** Drop the copy of a page, e.g. because the page was deleted. */
+  void Erase(page_id_t page_id);
+
+  /** @return number of bytes of compressed data held */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return number of pages held */
+  auto Count() const -> size_t { return entries_.size(); }
+
+ private:
+  struct Entry {
+    std::unique_ptr<char[]> data_;
+    size_t size_;
+    /** Position in insertion_order_ */
+    std::list<page_id_t>::iterator position_;
+  };
+
+  void EraseEntry(std::unordered_map<page_id_t, Entry>::iterator entry);
+
+  const size_t capacity_;
+  size_t size_{0};
+  std::unordered_map<page_id_t, Entry> entries_;
+  /** Cached page ids, oldest first */
+  std::list<page_id_t> insertion_order_;
+  /** Tickets of the reserved inserts */
+  std::unordered_map<page_id_t, uint64_t> reservations_;
+  uint64_t next_ticket_{0};
+  /** Output buffer of the compressor, so pages that turn out not to compress well cost no allocation */
+  std::array<char, MAX_COMPRESSED_SIZE> scratch_;
+};
+
+}  // namespace bustub
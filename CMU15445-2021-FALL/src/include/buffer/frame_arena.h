@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** What kind of virtual memory pages back a FrameArena. */
+enum class FrameBacking {
+  /** explicit huge pages reserved by the administrator (MAP_HUGETLB) */
+  HUGETLB,
+  /** regular pages the kernel was asked to merge into transparent huge pages (MADV_HUGEPAGE) */
+  TRANSPARENT_HUGE_PAGES,
+  /** regular pages */
+  REGULAR_PAGES,
+};
+
+/**
+ * FrameArena is the memory of a buffer pool's frames, mapped directly from the kernel instead of the heap. Large
+ * arenas are backed by huge pages, so that random accesses over a big pool miss the TLB far less often, and an arena
+ * can be bound to the memory of one NUMA node.
+ *
+ * The memory is zeroed and is not touched by the arena itself, so with a NUMA node given, the first access already
+ * allocates it on that node.
+ */
+class FrameArena {
+ public:
+  /** Size of a huge page; smaller arenas are always backed by regular pages. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+  /** Leaves the placement of the memory to the kernel's default policy (the node of the first access). */
+  static constexpr int NO_NUMA_NODE = -1;
+
+  /**
+   * Map a new arena. Tries explicit huge pages first, which only works if the system has them reserved, and falls
+   * back to transparent huge pages.
+   * @param size number of bytes
+   * @param numa_node node whose memory backs the arena, or NO_NUMA_NODE
+   * @param huge_pages false to back the arena with regular pages regardless of its size
+   */
+  explicit FrameArena(size_t size, int numa_node = NO_NUMA_NODE, bool huge_pages = true);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the start of the arena, aligned to HUGE_PAGE_SIZE if it is backed by huge pages */
+  auto Data() const -> char * { return data_; }
+
+  /** @return the kind of pages backing the arena */
+  auto GetBacking() const -> FrameBacking { return backing_; }
+
+  /**
+   * Give the memory of a range of the arena back to the kernel; it reads as zeros, and is allocated again, when it is
+   * touched next. Only the whole pages of the backing inside the range are released.
+   * @param begin start of the range
+   * @param length number of bytes
+   */
+  void Release(char *begin, size_t length);
+
+  /** @return the node the arena is bound to, or NO_NUMA_NODE if none was requested or the kernel refused */
+  auto GetNumaNode() const -> int { return numa_node_; }
+
+  /** @return number of NUMA nodes of the machine, 1 if it is not a NUMA system */
+  static auto NumaNodeCount() -> int;
+
+  /**
+   * Restrict a thread to the CPUs of a NUMA node, e.g. the background threads of a buffer pool instance whose frames
+   * live on that node.
+   * @return false if the node has no CPUs or the kernel refused
+   */
+  static auto BindThread(std::thread *thread, int numa_node) -> bool;
+
+ private:
+  char *data_{nullptr};
+  /** Length of the mapping, the requested size rounded up to whole pages */
+  size_t mapped_size_{0};
+  FrameBacking backing_{FrameBacking::REGULAR_PAGES};
+  int numa_node_{NO_NUMA_NODE};
+};
+
+}  // namespace bustub
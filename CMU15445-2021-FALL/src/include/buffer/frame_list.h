@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_list.h
+//
+// Identification: src/include/buffer/frame_list.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameList is a doubly linked list of frame ids 0..num_frames-1, each of which is in the list at most once. The links
+ * live in arrays indexed by frame id that are allocated up front, so no operation allocates memory or chases a heap
+ * pointer, and every operation, including removing a frame from the middle, takes constant time.
+ *
+ * FrameList is not thread-safe; its owner serializes access.
+ */
+class FrameList {
+ public:
+  /**
+   * Create an empty list.
+   * @param num_frames frames that may be linked are 0..num_frames-1
+   */
+  explicit FrameList(size_t num_frames) : links_(num_frames + 1), sentinel_(static_cast<frame_id_t>(num_frames)) {
+    links_[sentinel_] = {sentinel_, sentinel_};
+  }
+
+  DISALLOW_COPY_AND_MOVE(FrameList);
+
+  /** @return true if the frame is in the list */
+  auto Contains(frame_id_t frame_id) const -> bool {
+    CheckFrame(frame_id);
+    return links_[frame_id].next_ != UNLINKED;
+  }
+
+  /** @return number of frames in the list */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return true if the list holds no frames */
+  auto Empty() const -> bool { return size_ == 0; }
+
+  /** @return the first frame, the list must not be empty */
+  auto Front() const -> frame_id_t { return links_[sentinel_].next_; }
+
+  /** @return the last frame, the list must not be empty */
+  auto Back() const -> frame_id_t { return links_[sentinel_].prev_; }
+
+  /** @return the frame after frame_id, or INVALID_FRAME at the end of the list */
+  auto Next(frame_id_t frame_id) const -> frame_id_t {
+    const frame_id_t next = links_[frame_id].next_;
+    return next == sentinel_ ? INVALID_FRAME : next;
+  }
+
+  /** @return the frame before frame_id, or INVALID_FRAME at the start of the list */
+  auto Prev(frame_id_t frame_id) const -> frame_id_t {
+    const frame_id_t prev = links_[frame_id].prev_;
+    return prev == sentinel_ ? INVALID_FRAME : prev;
+  }
+
+  /** Insert a frame that is not in the list at the front. */
+  void PushFront(frame_id_t frame_id) { LinkAfter(sentinel_, frame_id); }
+
+  /** Insert a frame that is not in the list at the back. */
+  void PushBack(frame_id_t frame_id) { LinkAfter(links_[sentinel_].prev_, frame_id); }
+
+  /** Remove and return the first frame, the list must not be empty. */
+  auto PopFront() -> frame_id_t {
+    const frame_id_t frame_id = Front();
+    Remove(frame_id);
+    return frame_id;
+  }
+
+  /** Remove and return the last frame, the list must not be empty. */
+  auto PopBack() -> frame_id_t {
+    const frame_id_t frame_id = Back();
+    Remove(frame_id);
+    return frame_id;
+  }
+
+  /**
+   * Unlink a frame.
+   * @return false if the frame was not in the list
+   */
+  auto Remove(frame_id_t frame_id) -> bool {
+    if (!Contains(frame_id)) {
+      return false;
+    }
+    Links &links = links_[frame_id];
+    links_[links.prev_].next_ = links.next_;
+    links_[links.next_].prev_ = links.prev_;
+    links = {UNLINKED, UNLINKED};
+    size_--;
+    return true;
+  }
+
+  /** Returned by Next() and Prev() at the ends of the list. */
+  static constexpr frame_id_t INVALID_FRAME = -1;
+
+ private:
+  struct Links {
+    frame_id_t prev_{UNLINKED};
+    frame_id_t next_{UNLINKED};
+  };
+
+  /** Link value of a frame that is not in the list. */
+  static constexpr frame_id_t UNLINKED = -1;
+
+  void CheckFrame(frame_id_t frame_id) const {
+    BUSTUB_ASSERT(frame_id >= 0 && frame_id < sentinel_, "frame id out of range");
+  }
+
+  void LinkAfter(frame_id_t prev, frame_id_t frame_id) {
+    BUSTUB_ASSERT(!Contains(frame_id), "frame is already in the list");
+    const frame_id_t next = links_[prev].next_;
+    links_[frame_id] = {prev, next};
+    links_[prev].next_ = frame_id;
+    links_[next].prev_ = frame_id;
+    size_++;
+  }
+
+  /** Links of every frame, followed by the sentinel that closes the list into a ring. */
+  std::vector<Links> links_;
+  const frame_id_t sentinel_;
+  size_t size_{0};
+};
+
+}  // namespace bustub
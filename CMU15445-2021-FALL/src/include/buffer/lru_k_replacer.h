@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame whose K-th most recent access is the oldest (the largest backward K-distance).
+ * Frames with fewer than K recorded accesses have an infinite backward K-distance and are evicted first, oldest first
+ * access first. A page touched once by a sequential scan therefore never displaces a page that was accessed K times.
+ *
+ * Every Pin() counts as an access. The buffer pool pins a frame in the replacer when a page is loaded and whenever its
+ * pin count leaves zero, so fetches of a page that is already pinned are counted once. A frame's history is dropped
+ * when it is victimized or removed, so the next page loaded into it starts from scratch.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses tracked per frame
+   */
+  LRUKReplacer(size_t num_pages, size_t k);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+ private:
+  /** Eviction order key: <timestamp, frame id>. */
+  using entry_t = std::pair<uint64_t, frame_id_t>;
+
+  struct FrameInfo {
+    /** Timestamps of the last (up to) k accesses, oldest first. */
+    std::deque<uint64_t> history_;
+    bool evictable_{false};
+  };
+
+  /** Record an access to a frame. Caller holds latch_. */
+  void RecordAccess(FrameInfo *info);
+
+  /** @return the eviction-ordered set an evictable frame belongs in. Caller holds latch_. */
+  auto ListOf(const FrameInfo &info) -> std::set<entry_t> & {
+    return info.history_.size() < k_ ? history_list_ : cache_list_;
+  }
+
+  /** Drop a frame from the eviction order and forget its history. Caller holds latch_. */
+  void Reset(frame_id_t frame_id);
+
+  const size_t k_;
+  std::vector<FrameInfo> frames_;
+  /** Evictable frames with fewer than k accesses, ordered by their first recorded access. */
+  std::set<entry_t> history_list_;
+  /** Evictable frames with k accesses, ordered by their k-th most recent access. */
+  std::set<entry_t> cache_list_;
+  uint64_t current_timestamp_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
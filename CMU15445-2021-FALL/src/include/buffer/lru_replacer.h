@@ -12,11 +12,10 @@
 
 #pragma once
 
-#include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <vector>
 
+#include "buffer/frame_list.h"
 #include "buffer/replacer.h"
 #include "common/config.h"
 
@@ -55,16 +54,18 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  void NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
   //void DeleteNode(LinkListNode *curr);
 
  private:
   // TODO(student): implement me!
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> data_idx_;
   LinkListNode *head_{nullptr};
   LinkListNode *tail_{nullptr};
   std::mutex data_latch_;
 
-  std::list<frame_id_t> lru_list_;
+  /** Unpinned frames, most recently unpinned first. */
+  FrameList lru_list_;
 };
 
 }  // namespace bustub
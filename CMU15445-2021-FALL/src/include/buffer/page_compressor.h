@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.h
+//
+// Identification: src/include/buffer/page_compressor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * PageCompressor is a fast byte-oriented LZ77 codec in the LZ4 block format: a sequence of literal runs, each
+ * followed by a copy of earlier output given as a 16-bit offset and a length. It trades ratio for speed, which suits
+ * database pages, whose compressible parts are mostly zeroed free space and repeated column values.
+ */
+class PageCompressor {
+ public:
+  /** Shortest match worth encoding; a match costs at least a 2-byte offset plus its share of a token. */
+  static constexpr size_t MIN_MATCH = 4;
+  /** Matches reach at most this far back, the range of the 16-bit offset. */
+  static constexpr size_t MAX_OFFSET = 65535;
+
+  /**
+   * Compress a buffer.
+   * @param src data to compress, at most 64 KB
+   * @param src_size number of bytes to compress
+   * @param[out] dst buffer for the compressed data
+   * @param dst_capacity size of dst
+   * @return size of the compressed data, 0 if it does not fit into dst_capacity
+   */
+  static auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t;
+
+  /**
+   * Decompress a buffer compressed by Compress().
+   * @param src compressed data
+   * @param src_size size of the compressed data
+   * @param[out] dst buffer for the decompressed data
+   * @param dst_size number of bytes the data decompresses to
+   * @return false if the data is malformed or does not decompress to exactly dst_size bytes
+   */
+  static auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool;
+};
+
+}  // namespace bustub
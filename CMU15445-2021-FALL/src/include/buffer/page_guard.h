@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/buffer/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * Casts a latched page to the type it is accessed as. Types derived from Page (e.g. TablePage) wrap the page itself,
+ * any other type (e.g. HashTableDirectoryPage) is a layout of the page's data.
+ */
+template <typename T>
+inline auto PageAs(Page *page) -> T * {
+  if constexpr (std::is_base_of_v<Page, T>) {
+    return static_cast<T *>(page);
+  } else {
+    return reinterpret_cast<T *>(page->GetData());
+  }
+}
+
+/**
+ * ReadPageGuard holds a pin and a read latch on a page, and releases both when it goes out of scope or is dropped,
+ * so no return path can leak the pin. Guards are move-only; the moved-from guard no longer holds the page.
+ *
+ * A guard that holds no page (because the buffer pool could not fetch it) is not valid, and must not be accessed.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over a page that is already pinned and read latched.
+   * @param bpm the buffer pool to unpin the page from
+   * @param page the page, nullptr for an invalid guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept;
+
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  DISALLOW_COPY(ReadPageGuard);
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, instead of at the end of the scope. Does nothing if the guard is not valid. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the page */
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the page's data, to be read only */
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  /** @return the page as the given type, to be read only */
+  template <typename T>
+  auto As() const -> T * {
+    return PageAs<T>(page_);
+  }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+};
+
+/**
+ * WritePageGuard holds a pin and a write latch on a page, and releases both when it goes out of scope or is dropped.
+ * The page is unpinned dirty if it was accessed through AsMut() or marked dirty.
+ *
+ * A guard that holds no page (because the buffer pool could not fetch or create it) is not valid, and must not be
+ * accessed.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over a page that is already pinned and write latched.
+   * @param bpm the buffer pool to unpin the page from
+   * @param page the page, nullptr for an invalid guard
+   * @param is_dirty true if the page has to be unpinned dirty in any case, e.g. a new page
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page, bool is_dirty = false)
+      : bpm_(bpm), page_(page), is_dirty_(is_dirty) {}
+
+  WritePageGuard(WritePageGuard &&that) noexcept;
+
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  DISALLOW_COPY(WritePageGuard);
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, instead of at the end of the scope. Does nothing if the guard is not valid. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the page */
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** Unpin the page dirty, for callers that modified it through As(). */
+  void MarkDirty() { is_dirty_ = true; }
+
+  /** @return the page's data, to be read only */
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  /** @return the page's data; the page is unpinned dirty */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the page as the given type, without marking it dirty */
+  template <typename T>
+  auto As() const -> T * {
+    return PageAs<T>(page_);
+  }
+
+  /** @return the page as the given type; the page is unpinned dirty */
+  template <typename T>
+  auto AsMut() -> T * {
+    is_dirty_ = true;
+    return PageAs<T>(page_);
+  }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+}  // namespace bustub
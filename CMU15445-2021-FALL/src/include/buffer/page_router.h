@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_router.h
+//
+// Identification: src/include/buffer/page_router.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** How a parallel buffer pool spreads page ids over its instances. */
+enum class PageRouting {
+  /** page_id % n: adjacent pages live in different instances */
+  MODULO,
+  /** (page_id / extent_size) % n: each extent of adjacent pages lives in one instance */
+  EXTENT,
+  /** hash(page_id / extent_size) % n: like EXTENT, but extents are scattered to break up strided access patterns */
+  HASH,
+};
+
+/**
+ * PageRouter maps page ids to the buffer pool instance that owns them, and walks the page ids an instance owns so
+ * that each instance can allocate pages only it is responsible for.
+ */
+class PageRouter {
+ public:
+  /** Default number of adjacent pages that live in the same instance under EXTENT and HASH routing. */
+  static constexpr uint32_t DEFAULT_EXTENT_SIZE = 64;
+
+  /**
+   * @param routing the routing policy
+   * @param num_instances number of buffer pool instances
+   * @param extent_size number of adjacent pages per extent, ignored by MODULO routing
+   */
+  explicit PageRouter(PageRouting routing = PageRouting::MODULO, uint32_t num_instances = 1,
+                      uint32_t extent_size = DEFAULT_EXTENT_SIZE)
+      : routing_(routing),
+        num_instances_(num_instances),
+        extent_size_(routing == PageRouting::MODULO ? 1 : extent_size) {
+    BUSTUB_ASSERT(num_instances_ > 0 && extent_size_ > 0, "a router needs instances and non-empty extents");
+  }
+
+  /** @return the routing policy */
+  auto GetRouting() const -> PageRouting { return routing_; }
+
+  /** @return number of adjacent pages an instance owns in a row, 1 for MODULO routing */
+  auto GetExtentSize() const -> uint32_t { return extent_size_; }
+
+  /** @return index of the instance that owns the page */
+  auto InstanceOf(page_id_t page_id) const -> uint32_t {
+    const uint64_t extent = static_cast<uint64_t>(page_id) / extent_size_;
+    if (routing_ == PageRouting::HASH) {
+      return static_cast<uint32_t>(Mix(extent) % num_instances_);
+    }
+    return static_cast<uint32_t>(extent % num_instances_);
+  }
+
+  /** @return the smallest page id the instance owns */
+  auto FirstPageId(uint32_t instance_index) const -> page_id_t {
+    if (routing_ != PageRouting::HASH) {
+      return static_cast<page_id_t>(instance_index * extent_size_);
+    }
+    return NextPageId(-1, instance_index);
+  }
+
+  /**
+   * @param page_id a page id owned by the instance (or -1 under HASH routing, to find the first one)
+   * @param instance_index the instance
+   * @return the smallest page id greater than page_id that the instance owns
+   */
+  auto NextPageId(page_id_t page_id, uint32_t instance_index) const -> page_id_t {
+    page_id_t next = page_id + 1;
+    if (routing_ != PageRouting::HASH) {
+      // Past the end of its extent, the instance's next extent starts num_instances_ extents further.
+      if (InstanceOf(next) != instance_index) {
+        next = static_cast<page_id_t>((static_cast<uint32_t>(page_id) / extent_size_ + num_instances_) * extent_size_);
+      }
+      return next;
+    }
+    while (InstanceOf(next) != instance_index) {
+      next = static_cast<page_id_t>((static_cast<uint32_t>(next) / extent_size_ + 1) * extent_size_);
+    }
+    return next;
+  }
+
+ private:
+  /** Finalizer of MurmurHash3, spreads consecutive extent numbers over all instances. */
+  static auto Mix(uint64_t x) -> uint64_t {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  PageRouting routing_;
+  uint32_t num_instances_;
+  uint32_t extent_size_;
+};
+
+}  // namespace bustub
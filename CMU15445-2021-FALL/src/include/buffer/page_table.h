@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps resident page ids to the frames holding them.
+ *
+ * It is an open-addressed (linear probing) hash table whose slots are single 64-bit atomic words packing
+ * <page_id, frame_id>, so a slot is always read and written as a whole. Lookups never take a lock: readers probe
+ * optimistically and validate against a version counter that writers bump around any operation that moves entries.
+ * Erased slots become tombstones instead of being shifted back, so ordinary inserts and erases never move an entry
+ * and never invalidate concurrent readers; the version only changes when the table is compacted.
+ *
+ * Writers (Insert / Erase) must be serialized by the caller, which the buffer pool does with its instance latch.
+ */
+class PageTable {
+ public:
+  /**
+   * Create a new PageTable.
+   * @param num_frames the maximum number of entries the table will be required to hold
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Look up the frame holding a page. Safe to call concurrently with writers and never blocks on them.
+   * @param page_id id of the page to look up
+   * @param[out] frame_id frame holding the page, if found
+   * @return true if the page was found, false otherwise
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool;
+
+  /**
+   * Map a page to a frame. The page must not already be present. Caller must serialize writers.
+   * @param page_id id of the page
+   * @param frame_id frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Remove the mapping for a page. Caller must serialize writers.
+   * @param page_id id of the page
+   * @return true if the page was present, false otherwise
+   */
+  auto Erase(page_id_t page_id) -> bool;
+
+  /** @return the number of pages in the table */
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  using slot_t = uint64_t;
+
+  /** Slot value for a slot that has never been used since the last compaction; terminates a probe. */
+  static constexpr slot_t EMPTY_SLOT = ~static_cast<slot_t>(0);
+  /** Slot value for an erased slot; probes continue past it. */
+  static constexpr slot_t TOMBSTONE_SLOT = EMPTY_SLOT - 1;
+
+  static inline auto Pack(page_id_t page_id, frame_id_t frame_id) -> slot_t {
+    return (static_cast<slot_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline auto SlotPageId(slot_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static inline auto SlotFrameId(slot_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** @return the home slot of a page id */
+  inline auto Home(page_id_t page_id) const -> size_t {
+    // Fibonacci hashing: page ids of one instance are strided by the number of instances, so mix before masking.
+    return (static_cast<uint32_t>(page_id) * 0x9E3779B9U) >> shift_;
+  }
+
+  /** Rewrite all live entries into a tombstone-free layout. Readers retry while this runs. */
+  void Compact();
+
+  /** Number of slots, always a power of two. */
+  size_t capacity_;
+  /** 32 - log2(capacity_), used by Home(). */
+  uint32_t shift_;
+  std::unique_ptr<std::atomic<slot_t>[]> slots_;
+  /** Number of live entries. Only touched by writers. */
+  size_t size_{0};
+  /** Number of tombstones. Only touched by writers. */
+  size_t tombstones_{0};
+  /** Sequence lock guarding entry movement: odd while a compaction is in progress. */
+  std::atomic<uint64_t> version_{0};
+};
+
+}  // namespace bustub
@@ -12,11 +12,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/page_router.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -31,9 +33,17 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param routing how page ids are mapped to instances
+   * @param extent_size number of adjacent pages that live in the same instance under EXTENT and HASH routing
+   * @param numa_aware spread the instances over the NUMA nodes: the frames and background threads of instance i live
+   * on node i % FrameArena::NumaNodeCount()
+   * @param max_pool_size number of frames Resize() can grow each BufferPoolManagerInstance to (0 = pool_size)
+   * @param compressed_cache_size bytes of memory for compressed copies of evicted pages, per instance (0 = none)
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, PageRouting routing = PageRouting::MODULO,
+                            uint32_t extent_size = PageRouter::DEFAULT_EXTENT_SIZE, bool numa_aware = false,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -43,6 +53,23 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * Change the total number of frames while the buffer pool is in use, spreading them evenly over the instances. The
+   * number of instances stays the same, since it decides which instance every page id belongs to.
+   * @param new_size total number of frames, at least one per instance
+   * @return true if every instance was resized
+   */
+  bool Resize(size_t new_size) override;
+
+  /** @return the counters of all instances added up */
+  BufferPoolStats GetStats() override;
+
+  /**
+   * Callers that work on a range of pages for a while can bind their thread to this node with FrameArena::BindThread.
+   * @return the NUMA node the frame of the page lives on, or FrameArena::NO_NUMA_NODE if the pool is not NUMA aware
+   */
+  int GetNumaNode(page_id_t page_id);
+
  protected:
   /**
    * @param page_id id of page
@@ -57,6 +84,21 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the responsible instance, loading it through the given access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller
+   * @return the requested page
+   */
+  Page *FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Queue pages to be loaded by the prefetcher of the responsible instance.
+   * @param page_id id of the first page to load
+   * @param chain how far to read ahead from the first page
+   */
+  void PrefetchPgImp(page_id_t page_id, const PrefetchChain &chain) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -79,6 +121,21 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, taking it from an extent: in the instance that owns the rest of the extent,
+   * or else round robin like NewPgImp(), in a new extent.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgExtentImp(page_id_t *page_id, DiskExtent *extent) override;
+
+  /**
+   * Gives back the pages of an extent that were not used.
+   * @param extent the extent
+   */
+  void ReleaseExtentImp(DiskExtent *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,9 +153,10 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   
   std::vector<BufferPoolManager *> instances_;  //ڴ洢Ļ
   //std::vector<std::shared_ptr<BufferPoolManager>> instances_;
-  size_t start_idx_{0};     
+  std::atomic<size_t> start_idx_{0};  //NewPageʼתĻأ߳̿ͬʱҳ     
   size_t pool_size_;        //¼ص
   size_t num_instances_;    //صĸ
+  PageRouter router_;       //ҳIDصӳ
   
 };
 }  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a BufferPoolManagerInstance can be configured with. */
+enum class ReplacerType { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -45,6 +50,28 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Report the frames that would be victimized next, without removing them. Used to clean pages ahead of eviction;
+   * replacers that cannot predict their victims report nothing.
+   * @param max_frames maximum number of frames to report
+   * @param[out] frame_ids the next victims, in eviction order
+   */
+  virtual void NextVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {}
+
+  /**
+   * Forget a frame whose page has left the buffer pool without being victimized (e.g. a deleted page). Replacers
+   * that keep per-frame access history drop it here.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * @return true if the replacer must be told about every pin and unpin, in order. Otherwise the buffer pool only
+   * reports frames whose pin count dropped to zero, concurrently and without a latch; a victim the replacer picks
+   * may then turn out to be pinned, and the buffer pool reports it again once it is unpinned.
+   */
+  virtual auto NeedsPins() const -> bool { return true; }
 };
 
 }  // namespace bustub
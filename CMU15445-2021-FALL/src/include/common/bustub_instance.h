@@ -17,17 +17,26 @@
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/direct_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file
+   * @param direct_io read and write pages with O_DIRECT and io_uring (see DirectDiskManager)
+   */
+  explicit BustubInstance(const std::string &db_file_name, bool direct_io = false) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    if (direct_io) {
+      disk_manager_ = new DirectDiskManager(db_file_name);
+    } else {
+      disk_manager_ = new DiskManager(db_file_name);
+    }
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
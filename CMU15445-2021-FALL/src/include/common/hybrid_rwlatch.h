@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_rwlatch.h
+//
+// Identification: src/include/common/hybrid_rwlatch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Reader-Writer latch in a single atomic word that spins before it blocks. Critical sections under page latches are
+ * usually tens of nanoseconds, far shorter than a sleep and wake-up through the kernel, so a waiter first spins with
+ * exponential backoff, and only parks on a futex once the latch stays busy.
+ *
+ * Unlike ReaderWriterLatch, an uncontended acquire or release is a single atomic instruction and touches no other
+ * memory. Like it, the latch is not recursive: with writer preference, a thread that read latches twice can deadlock
+ * with a waiting writer.
+ */
+class HybridReaderWriterLatch {
+ public:
+  /** Number of failed attempts to acquire the latch, spent spinning with backoff, before a waiter parks. */
+  static constexpr int SPIN_ATTEMPTS = 16;
+  /** Most pause instructions between two attempts. */
+  static constexpr uint32_t MAX_BACKOFF = 64;
+
+  /**
+   * @param prefer_writers if true, a waiting writer keeps new readers out, so a stream of overlapping readers cannot
+   * starve writers; if false, readers get in whenever no writer holds the latch
+   */
+  explicit HybridReaderWriterLatch(bool prefer_writers = true) : prefer_writers_(prefer_writers) {}
+
+  DISALLOW_COPY(HybridReaderWriterLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    for (int attempt = 0;; attempt++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & (WRITER | READER_MASK)) == 0) {
+        if (state_.compare_exchange_weak(state, (state | WRITER) & ~WRITER_WAITING, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      if (prefer_writers_ && (state & WRITER_WAITING) == 0) {
+        state_.fetch_or(WRITER_WAITING, std::memory_order_relaxed);
+      }
+      Wait(attempt);
+    }
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    if ((state_.fetch_and(~(WRITER | PARKED), std::memory_order_release) & PARKED) != 0) {
+      WakeAll();
+    }
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    const uint32_t blocking = prefer_writers_ ? WRITER | WRITER_WAITING : WRITER;
+    for (int attempt = 0;; attempt++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & blocking) == 0 && (state & READER_MASK) != READER_MASK) {
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      Wait(attempt);
+    }
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    const uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    // Waiters can only be blocked on the last reader (a writer) or on a full reader count.
+    if ((state & PARKED) != 0 && ((state & READER_MASK) == 1 || (state & READER_MASK) == READER_MASK)) {
+      state_.fetch_and(~PARKED, std::memory_order_relaxed);
+      WakeAll();
+    }
+  }
+
+ private:
+  /** Set while a writer holds the latch */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a writer waits for the readers to leave; keeps new readers out if writers are preferred */
+  static constexpr uint32_t WRITER_WAITING = 1U << 30;
+  /** Set while threads are parked on the futex; the next release wakes them */
+  static constexpr uint32_t PARKED = 1U << 29;
+  /** The low bits count the readers */
+  static constexpr uint32_t READER_MASK = PARKED - 1;
+
+  /** Back off after a failed attempt; after SPIN_ATTEMPTS of them, sleep until the next release. */
+  void Wait(int attempt) {
+    if (attempt < SPIN_ATTEMPTS) {
+      const uint32_t pauses = std::min<uint32_t>(1U << attempt, MAX_BACKOFF);
+      for (uint32_t i = 0; i < pauses; i++) {
+        Pause();
+      }
+      return;
+    }
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & (WRITER | READER_MASK)) == 0) {
+      return;
+    }
+    if ((state & PARKED) == 0 && !state_.compare_exchange_strong(state, state | PARKED, std::memory_order_relaxed)) {
+      return;
+    }
+    // Sleeps only if the word is unchanged, so a release between the check and the sleep is not missed.
+    syscall(SYS_futex, &state_, FUTEX_WAIT_PRIVATE, state | PARKED, nullptr, nullptr, 0);
+  }
+
+  void WakeAll() { syscall(SYS_futex, &state_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0); }
+
+  static void Pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  std::atomic<uint32_t> state_{0};
+  const bool prefer_writers_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimistic_latch.h
+//
+// Identification: src/include/common/optimistic_latch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Versioned latch for optimistic lock coupling. Writers exclude each other and keep the version odd while they hold
+ * the latch. Readers never write to the latch: they take the version before reading, validate afterwards that it is
+ * unchanged, and start over if a writer got in between.
+ *
+ * An optimistic reader may see data torn by a concurrent writer. It must not act on what it read before validating,
+ * and must bounds-check any offset or count it reads before using it to read further.
+ */
+class OptimisticLatch {
+ public:
+  OptimisticLatch() = default;
+
+  DISALLOW_COPY(OptimisticLatch);
+
+  /**
+   * Start an optimistic read, waiting for a writer that holds the latch to finish.
+   * @return the version to pass to Validate()
+   */
+  auto ReadBegin() const -> uint64_t {
+    uint64_t version = version_.load(std::memory_order_acquire);
+    while (IsLocked(version)) {
+      std::this_thread::yield();
+      version = version_.load(std::memory_order_acquire);
+    }
+    return version;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version ReadBegin() returned
+   * @return true if no writer held the latch since ReadBegin(), so everything read in between is consistent
+   */
+  auto Validate(uint64_t version) const -> bool {
+    // Keep the reads of the protected data from moving past the version check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Acquire the latch for writing.
+   */
+  void WLock() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    while (IsLocked(version) || !version_.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+      std::this_thread::yield();
+      version = version_.load(std::memory_order_relaxed);
+    }
+    // Readers that see any write made under the latch must also see the odd version when they validate.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /**
+   * Turn an optimistic read into a write latch, if no writer got in since ReadBegin().
+   * @param version the version ReadBegin() returned
+   * @return true if the latch is now held for writing, false if the read has to start over
+   */
+  auto TryUpgrade(uint64_t version) -> bool {
+    if (!version_.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() { version_.fetch_add(1, std::memory_order_release); }
+
+ private:
+  static auto IsLocked(uint64_t version) -> bool { return (version & 1) != 0; }
+
+  std::atomic<uint64_t> version_{0};
+};
+
+}  // namespace bustub
@@ -51,7 +51,7 @@ enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
 /**
  * Type of write operation.
  */
-enum class WType { INSERT = 0, DELETE, UPDATE };
+enum class WType { INSERT = 0, DELETE, UPDATE, BULK_INSERT };
 
 class TableHeap;
 class Catalog;
@@ -66,6 +66,7 @@ class TableWriteRecord {
   TableWriteRecord(RID rid, WType wtype, const Tuple &tuple, TableHeap *table)
       : rid_(rid), wtype_(wtype), tuple_(tuple), table_(table) {}
 
+  /** For a bulk insert, the last page loaded and, as slot number, the number of pages loaded. */
   RID rid_;
   WType wtype_;
   /** The tuple is only used for the update operation. */
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
 #include "storage/page/hash_table_bucket_page.h"
@@ -122,19 +123,19 @@ class ExtendibleHashTable {
   page_id_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Fetches the directory page from the buffer pool manager, read latched.
    *
-   * @return a pointer to the directory page
+   * @return a guard holding the directory page
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  ReadPageGuard FetchDirectoryPage();
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
+   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id, read latched.
    *
    * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @return a guard holding the bucket page
    */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+  ReadPageGuard FetchBucketPage(page_id_t bucket_page_id);
 
   /**
    * Performs insertion with an optional bucket splitting.  If the
@@ -157,7 +158,8 @@ class ExtendibleHashTable {
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
    *
-   * Note: we do not merge recursively.
+   * After a merge, the merged bucket is merged again while it or its new split image is empty, so that removing
+   * every key shrinks the directory all the way back.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key that was removed
@@ -165,9 +167,20 @@ class ExtendibleHashTable {
    */
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * @param bucket_page_id the page_id of the bucket
+   * @return true if the bucket page holds no pairs
+   */
+  bool IsBucketEmpty(page_id_t bucket_page_id);
+
   // member variables
   page_id_t directory_page_id_;
   BufferPoolManager *buffer_pool_manager_;
+  /**
+   * Where the directory and bucket pages come from, so they lie next to each other on disk. The table may outlive its
+   * buffer pool, so the unused pages are not given back; they are free again after a restart.
+   */
+  DiskExtent extent_;
   KeyComparator comparator_;
 
   // Readers includes inserts and removes, writers are splits and merges
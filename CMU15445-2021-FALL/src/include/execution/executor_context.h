@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "catalog/catalog.h"
 #include "concurrency/transaction.h"
 #include "storage/page/tmp_tuple_page.h"
@@ -61,6 +62,12 @@ class ExecutorContext {
   /** @return the transaction manager */
   auto GetTransactionManager() -> TransactionManager * { return txn_mgr_; }
 
+  /** @return the number of frames a sequential scan recycles per buffer pool instance (0 = no scan ring) */
+  auto GetScanRingSize() const -> size_t { return scan_ring_size_; }
+
+  /** @param scan_ring_size the number of frames a sequential scan recycles per buffer pool instance (0 = no ring) */
+  void SetScanRingSize(size_t scan_ring_size) { scan_ring_size_ = scan_ring_size; }
+
  private:
   /** The transaction context associated with this executor context */
   /**ִĹ*/
@@ -77,6 +84,8 @@ class ExecutorContext {
   /** The lock manager associated with this executor context */
   /**ִĹ*/
   LockManager *lock_mgr_;
+  /** Ring size of the buffer access strategy used by sequential scans */
+  size_t scan_ring_size_{BufferAccessStrategy::DEFAULT_RING_SIZE};
 };
 
 }  // namespace bustub
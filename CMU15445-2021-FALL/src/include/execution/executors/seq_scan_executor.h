@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "concurrency/transaction_manager.h"
@@ -68,6 +69,9 @@ class SeqScanExecutor : public AbstractExecutor {
 
   TableIterator end_;
 
+  /** Keeps the pages read by the scan in a small ring of frames (nullptr if the context disabled the ring) */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
+
   bool is_same_schema_;	//ģʽģʽǷһ
 };
 }  // namespace bustub
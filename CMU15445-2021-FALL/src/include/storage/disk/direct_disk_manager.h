@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_disk_manager.h
+//
+// Identification: src/include/storage/disk/direct_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/io_uring.h"
+
+namespace bustub {
+
+/**
+ * DirectDiskManager reads and writes pages of the database file with O_DIRECT, bypassing the kernel page cache so that
+ * pages are only cached once, in the buffer pool. Page I/O goes through io_uring when the kernel supports it and falls
+ * back to pread/pwrite otherwise. There is no file-wide latch: any number of page reads and writes can be outstanding
+ * at the same time. The log file is handled exactly like in DiskManager.
+ */
+class DirectDiskManager : public DiskManager {
+ public:
+  /** Buffers handed to the kernel must be aligned to this; other buffers are copied through an aligned one. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+  /** Number of page requests that can be in flight in the io_uring at once. */
+  static constexpr uint32_t IO_URING_ENTRIES = 128;
+
+  /**
+   * Creates a new direct I/O disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param use_io_uring submit page I/O through io_uring if the kernel supports it, otherwise use pread/pwrite
+   */
+  explicit DirectDiskManager(const std::string &db_file, bool use_io_uring = true);
+
+  ~DirectDiskManager() override;
+
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** Writes all runs of adjacent pages concurrently. */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> *pages) override;
+
+  void DeallocatePage(page_id_t page_id) override;
+
+  /** @return true if the database file could be opened with O_DIRECT (some file systems, e.g. tmpfs, refuse it) */
+  auto IsDirect() const -> bool { return direct_; }
+
+  /** @return true if page I/O is submitted through io_uring */
+  auto UsesIoUring() const -> bool { return io_uring_ != nullptr; }
+
+ private:
+  /**
+   * Transfer one page between the database file and an aligned buffer.
+   * @return number of bytes transferred, or -errno
+   */
+  auto Transfer(bool write, char *buf, uint64_t offset) -> int;
+
+  /**
+   * Finish a transfer with pread/pwrite.
+   * @param done number of bytes of the transfer that are already done
+   * @return number of bytes transferred in total (short only at the end of the file), or -errno
+   */
+  auto TransferRest(bool write, char *buf, size_t len, uint64_t offset, size_t done) -> ssize_t;
+
+  int db_fd_{-1};
+  bool direct_{false};
+  std::unique_ptr<IoUring> io_uring_;
+};
+
+}  // namespace bustub
@@ -15,10 +15,14 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/disk_space_manager.h"
 
 namespace bustub {
 
@@ -28,32 +32,52 @@ namespace bustub {
  */
 class DiskManager {
  public:
+  /** A single write issued by WritePages() covers at most this many adjacent pages. */
+  static constexpr size_t MAX_COALESCED_PAGES = 256;
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
    */
   explicit DiskManager(const std::string &db_file);
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Write a batch of pages to the database file. The pages are written in page id order, and adjacent pages are
+   * coalesced into a single write. Page images that are already contiguous in memory are written in place.
+   * @param[in,out] pages distinct page ids and their raw page data; sorted by page id on return
+   */
+  virtual void WritePages(std::vector<std::pair<page_id_t, const char *>> *pages);
+
+  /**
+   * Free a page, so its id can be allocated again, and give its disk space back to the file system. The file keeps its
+   * size; the page reads back as zeros.
+   * @param page_id id of the page
+   */
+  virtual void DeallocatePage(page_id_t page_id);
+
+  /** @return the allocator of the pages of the database file; its bitmap is saved next to the file, as .space */
+  auto GetSpaceManager() -> DiskSpaceManager * { return space_manager_.get(); }
 
   /**
    * Flush the entire log buffer into disk.
@@ -89,6 +113,43 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
+ protected:
+  /**
+   * Punch a hole over a page of a file, where the file system supports it.
+   * @param fd the file, open for writing
+   * @param page_id id of the page
+   */
+  static void PunchHole(int fd, page_id_t page_id);
+
+  /**
+   * Sort a batch of pages by page id and split it into runs of adjacent pages.
+   * @param[in,out] pages the batch
+   * @return [begin, end) index ranges of the runs, each at most MAX_COALESCED_PAGES long
+   */
+  static auto CoalescePages(std::vector<std::pair<page_id_t, const char *>> *pages)
+      -> std::vector<std::pair<size_t, size_t>>;
+
+  /**
+   * @param pages a batch sorted by CoalescePages()
+   * @param run a run returned by CoalescePages()
+   * @return true if the images of the run follow each other in memory
+   */
+  static auto IsContiguous(const std::vector<std::pair<page_id_t, const char *>> &pages, std::pair<size_t, size_t> run)
+      -> bool;
+
+  /**
+   * @param pages a batch sorted by CoalescePages()
+   * @param run a run returned by CoalescePages()
+   * @param staging a buffer of at least MAX_COALESCED_PAGES pages
+   * @return the images of the run as one buffer: in place if they are contiguous, otherwise copied into staging
+   */
+  static auto RunData(const std::vector<std::pair<page_id_t, const char *>> &pages, std::pair<size_t, size_t> run,
+                      char *staging) -> const char *;
+
+  std::string file_name_;
+  std::atomic<int> num_writes_;
+  std::unique_ptr<DiskSpaceManager> space_manager_;
+
  private:
   auto GetFileSize(const std::string &file_name) -> int;
   // stream to write log file
@@ -96,9 +157,9 @@ class DiskManager {
   std::string log_name_;
   // stream to write db file
   std::fstream db_io_;
-  std::string file_name_;
+  // descriptor of the db file to punch holes through, -1 if it is closed
+  int hole_fd_{-1};
   int num_flushes_;
-  int num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
   // With multiple buffer pool instances, need to protect file access
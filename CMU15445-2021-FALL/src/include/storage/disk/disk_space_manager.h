@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_space_manager.h
+//
+// Identification: src/include/storage/disk/disk_space_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * DiskExtent is a run of EXTENT_SIZE adjacent pages whose free pages are reserved for one table heap or index. They
+ * are handed out in order, so they end up next to each other in the database file; when they run out, another extent
+ * is reserved. It is only changed by the DiskSpaceManager, under its latch; the buffer pool may read it without one, as
+ * a hint.
+ */
+struct DiskExtent {
+  /** The page of the extent to try next, INVALID_PAGE_ID if no extent is reserved */
+  std::atomic<page_id_t> next_page_id_{INVALID_PAGE_ID};
+  /** One past the last page of the extent */
+  std::atomic<page_id_t> end_page_id_{INVALID_PAGE_ID};
+};
+
+/**
+ * DiskSpaceManager keeps track of the pages of the database file that are in use, in a bitmap with one bit per page.
+ * It hands out the lowest free page, so deallocated pages are reused before the file grows, and reserves extents
+ * (aligned runs of EXTENT_SIZE adjacent pages) for callers that want their pages next to each other.
+ *
+ * The bitmap is saved in a file of its own, one page-sized chunk after the other. A chunk with new allocations is
+ * written back before any page it covers is written (see SaveAllocation()), so a page that is on disk is never free in
+ * the saved bitmap. Deallocations are written back lazily; after a crash, they are lost and the pages stay in use.
+ * Reservations are not saved at all: the unused pages of an extent are free again after a restart.
+ */
+class DiskSpaceManager {
+ public:
+  /** Number of adjacent pages in an extent. */
+  static constexpr uint32_t EXTENT_SIZE = 16;
+  /** Number of pages a chunk of the saved bitmap covers. */
+  static constexpr uint32_t PAGES_PER_CHUNK = PAGE_SIZE * 8;
+
+  /** Tells whether the caller can use a page, e.g. whether the page belongs to the caller's buffer pool instance. */
+  using PageFilter = std::function<bool(page_id_t)>;
+
+  /**
+   * Open the bitmap of a database file, creating it if there is none.
+   * @param file_name the file the bitmap is saved in, empty to keep it in memory only
+   * @param num_db_pages number of pages the database file has. A new database file (0 pages) starts a new bitmap;
+   * without a saved bitmap, all pages of an existing file are taken to be in use.
+   */
+  DiskSpaceManager(const std::string &file_name, page_id_t num_db_pages);
+
+  /** Writes back the bitmap. */
+  ~DiskSpaceManager();
+
+  DISALLOW_COPY_AND_MOVE(DiskSpaceManager);
+
+  /**
+   * Allocate the lowest free page the caller can use. Pages reserved for an extent are not handed out.
+   * @param usable tells whether the caller can use a page; it must accept some page past the end of the file
+   * @return the id of the page
+   */
+  auto AllocatePage(const PageFilter &usable) -> page_id_t;
+
+  /**
+   * Allocate a page for the owner of an extent: the next free page of its extent, or else the first page of a new
+   * extent. The new extent is the lowest one with a free page, and only its free pages are reserved, so holes inside
+   * the file are filled before the file grows.
+   * @param extent the extent of the caller
+   * @param usable tells whether the caller can use a page; it must accept some page of every extent past the end of
+   * the file
+   * @return the id of the page
+   */
+  auto AllocatePage(DiskExtent *extent, const PageFilter &usable) -> page_id_t;
+
+  /**
+   * Give back the pages of an extent that were not handed out, e.g. when its owner goes away.
+   * @param extent the extent
+   */
+  void ReleaseExtent(DiskExtent *extent);
+
+  /**
+   * Mark a page free, so it can be allocated again.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /**
+   * Write back the allocation of a page if it is not saved yet. To be called before the page itself is written.
+   * @param page_id id of the page
+   */
+  void SaveAllocation(page_id_t page_id);
+
+  /** Write back all changes to the bitmap. */
+  void Save();
+
+ private:
+  static constexpr size_t BITS_PER_WORD = 64;
+  static constexpr size_t WORDS_PER_CHUNK = PAGE_SIZE / sizeof(uint64_t);
+  static constexpr uint64_t EXTENT_MASK = (uint64_t{1} << EXTENT_SIZE) - 1;
+
+  /** @return true if the page's bit is set */
+  static auto TestBit(const std::vector<uint64_t> &bits, page_id_t page_id) -> bool;
+
+  /** @return true if the page is allocated or reserved */
+  auto IsTaken(page_id_t page_id) const -> bool;
+
+  /** @return the lowest page id at or after from that is neither allocated nor reserved */
+  auto FindFree(page_id_t from) const -> page_id_t;
+
+  /** @return the pages of the extent starting at first that are free and usable, one bit each; 0 if any is reserved */
+  auto FreePagesOf(page_id_t first, const PageFilter &usable) const -> uint64_t;
+
+  /** Make the bitmap cover page_id. */
+  void Grow(page_id_t page_id);
+
+  void MarkAllocated(page_id_t page_id);
+
+  /** Reserve the free pages of the extent starting at first for the caller, and allocate the first one. */
+  auto Reserve(DiskExtent *extent, page_id_t first, uint64_t free_pages) -> page_id_t;
+
+  /** ReleaseExtent() with latch_ held. */
+  void Unreserve(DiskExtent *extent);
+
+  void WriteChunk(size_t chunk);
+
+  std::string file_name_;
+  std::fstream file_;
+  /** Guards the members below */
+  std::mutex latch_;
+  std::vector<uint64_t> allocated_;
+  std::vector<uint64_t> reserved_;
+  /** Chunks with changes that are not saved */
+  std::vector<bool> dirty_chunks_;
+  /** Chunks with allocations that are not saved */
+  std::vector<bool> unsaved_allocations_;
+  /** No page below this one is free */
+  page_id_t first_free_{0};
+};
+
+}  // namespace bustub
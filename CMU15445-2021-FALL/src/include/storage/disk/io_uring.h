@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.h
+//
+// Identification: src/include/storage/disk/io_uring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * IoUring is a minimal io_uring submission/completion ring for positioned reads and writes, driven directly through
+ * the io_uring system calls.
+ *
+ * Any number of threads may call Execute() concurrently; their requests are in flight in the kernel at the same time.
+ * One waiting thread at a time reaps completions for everybody and wakes the others up.
+ */
+class IoUring {
+ public:
+  /** A positioned read or write of a single buffer. */
+  struct Request {
+    bool write_{false};
+    int fd_{-1};
+    char *buf_{nullptr};
+    uint32_t len_{0};
+    uint64_t offset_{0};
+    /** Number of bytes transferred, or -errno */
+    int result_{0};
+    /** Set once the completion for this request has been reaped */
+    bool done_{false};
+  };
+
+  /**
+   * Set up a new ring. Check IsValid(): the kernel may not support io_uring, or its reads and writes, or may refuse it.
+   * @param entries number of requests that can be in flight at once
+   */
+  explicit IoUring(uint32_t entries);
+
+  ~IoUring();
+
+  DISALLOW_COPY_AND_MOVE(IoUring);
+
+  /** @return true if the ring was set up and can execute requests */
+  auto IsValid() const -> bool { return ring_fd_ >= 0; }
+
+  /**
+   * Submit the requests and wait until all of them have completed.
+   * @param requests the requests; their result_ and done_ are filled in
+   * @param count number of requests
+   */
+  void Execute(Request *requests, size_t count);
+
+ private:
+  /** Queue a request in the submission ring. Caller holds latch_. */
+  void Push(Request *request);
+
+  /** Hand the queued requests to the kernel. Caller holds latch_. */
+  void Submit(uint32_t count);
+
+  /** Collect all available completions. Caller holds latch_. */
+  void Reap();
+
+  int ring_fd_{-1};
+  uint32_t sq_entries_{0};
+
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+
+  /** Requests submitted and not reaped yet; kept at or below sq_entries_ so the completion ring cannot overflow */
+  uint32_t in_flight_{0};
+  /** True while a thread waits in the kernel for completions on behalf of everybody */
+  bool reaping_{false};
+  /** Protects the rings, in_flight_, reaping_ and the done_ flags of the requests */
+  std::mutex latch_;
+  std::condition_variable cv_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * Page of a table heap's free-space map. It records, for up to CAPACITY heap pages, how much free space each has, as
+ * a category of PAGE_SIZE / 256 bytes: a page in category c has at least c * PAGE_SIZE / 256 free bytes. The pages of
+ * a free-space map form a singly linked list.
+ *
+ * Page format (size in bytes):
+ * ----------------------------------------------------------------------------------------------------
+ * | PageId (4) | NextPageId (4) | Count (4) | MaxCategory (1) | Unused (3) | HeapPageIds (4 * CAPACITY) |
+ * ----------------------------------------------------------------------------------------------------
+ * ----------------------------------
+ * | Categories (1 * CAPACITY) | ... |
+ * ----------------------------------
+ *
+ * MaxCategory is the largest category on the page, so a search skips pages without enough room for a tuple by their
+ * header alone.
+ */
+class FreeSpaceMapPage {
+ public:
+  /** Number of heap pages one free-space map page keeps track of. */
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - 16) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+  /**
+   * Initialize an empty free-space map page.
+   * @param page_id the page ID of this page
+   */
+  void Init(page_id_t page_id);
+
+  /** @return the page ID of this page */
+  auto GetPageId() const -> page_id_t { return page_id_; }
+
+  /** @return the page ID of the next page of the free-space map, INVALID_PAGE_ID if this is the last one */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /** Set the page ID of the next page of the free-space map. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return number of heap pages recorded on this page */
+  auto GetCount() const -> uint32_t { return count_; }
+
+  /** @return true if this page cannot record another heap page */
+  auto IsFull() const -> bool { return count_ == CAPACITY; }
+
+  /** @return the largest category recorded on this page */
+  auto GetMaxCategory() const -> uint8_t { return max_category_; }
+
+  /** @return the page ID of the heap page recorded at slot */
+  auto GetHeapPageId(uint32_t slot) const -> page_id_t { return heap_page_ids_[slot]; }
+
+  /** @return the category of the heap page recorded at slot */
+  auto GetCategory(uint32_t slot) const -> uint8_t { return categories_[slot]; }
+
+  /**
+   * Record a heap page in the next free slot. The page must not be full.
+   * @param heap_page_id the page ID of the heap page
+   * @param category the heap page's free-space category
+   * @return the slot the heap page was recorded at
+   */
+  auto Append(page_id_t heap_page_id, uint8_t category) -> uint32_t;
+
+  /**
+   * Change the category of a recorded heap page.
+   * @param slot the slot the heap page was recorded at
+   * @param category the heap page's new free-space category
+   */
+  void SetCategory(uint32_t slot, uint8_t category);
+
+  /**
+   * Forget the heap page recorded at slot. The slot keeps INVALID_PAGE_ID in category 0, so it is never found again.
+   * @param slot the slot the heap page was recorded at
+   */
+  void ClearSlot(uint32_t slot);
+
+  /**
+   * @param category the smallest category wanted
+   * @return the first slot whose category is at least category, or GetCount() if there is none
+   */
+  auto FindSlot(uint8_t category) const -> uint32_t;
+
+ private:
+  page_id_t page_id_;
+  page_id_t next_page_id_;
+  uint32_t count_;
+  uint8_t max_category_;
+  uint8_t unused_[3];
+  page_id_t heap_page_ids_[CAPACITY];
+  uint8_t categories_[CAPACITY];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE, "a free-space map page must fit in a page");
+
+}  // namespace bustub
@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
-#include "common/rwlatch.h"
+#include "common/hybrid_rwlatch.h"
+#include "common/optimistic_latch.h"
 
 namespace bustub {
 
@@ -24,14 +27,24 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data is not stored inline: a buffer pool keeps its Page objects densely packed in one array and the page data in
+ * another, page aligned one, so sweeps over the book-keeping of all frames do not stride over the data, and page data
+ * can be handed to O_DIRECT I/O as is.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates page data of its own and zeros it out. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
+
+  /**
+   * Constructor for a buffer pool frame. Zeros out the page data.
+   * @param data PAGE_SIZE bytes of page data owned by the caller, which must outlive the page
+   */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -42,17 +55,26 @@ class Page {
   /** @return the page id of this page */
   inline auto GetPageId() -> page_id_t { return page_id_; }
 
-  /** @return the pin count of this page */
-  inline auto GetPinCount() -> int { return pin_count_; }
+  /** @return the pin count of this page (frames that are free or being loaded report 0) */
+  inline auto GetPinCount() -> int {
+    const int pin_count = pin_count_.load();
+    return pin_count < 0 ? 0 : pin_count;
+  }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_latch_.WLock();
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_latch_.WUnlock();
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +82,19 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start reading the page without a latch. Unlike RLatch(), this does not write to the page, so readers on different
+   * threads do not contend. The caller must still hold a pin, and must validate before acting on what it read.
+   * @return the version to pass to ValidateOptimisticRead()
+   */
+  inline auto BeginOptimisticRead() const -> uint64_t { return version_latch_.ReadBegin(); }
+
+  /**
+   * @param version the version BeginOptimisticRead() returned
+   * @return true if nobody write latched the page since BeginOptimisticRead(), false if the read must start over
+   */
+  inline auto ValidateOptimisticRead(uint64_t version) const -> bool { return version_latch_.Validate(version); }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -81,23 +116,30 @@ class Page {
 
   //Pageǻеҳ
 
-  /** The actual data that is stored within a page. */
-  //data_Ӧҳʵ
-  char data_[PAGE_SIZE]{};
-
   /** The ID of this page. */
   //page_id_ҳڴ̹еҳID
-  page_id_t page_id_ = INVALID_PAGE_ID;
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
 
-  /** The pin count of this page. */
+  /** The pin count of this page. Negative while the frame is free or being loaded, so it cannot be pinned. */
   //pin_count_DBMSʹøҳûĿ
-  int pin_count_ = 0;
+  std::atomic<int> pin_count_{0};
 
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   //is_dirty_ҳԴ̶дغǷ޸
-  bool is_dirty_ = false;
-  /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  std::atomic<bool> is_dirty_{false};
+
+  /** Page data allocated by the page itself, if it is not a buffer pool frame. */
+  std::unique_ptr<char[]> owned_data_;
+
+  /** The actual data that is stored within a page. */
+  //data_Ӧҳʵ
+  char *data_;
+
+  /** Page latch. Held for tens of nanoseconds at a time, so it spins before it blocks. */
+  HybridReaderWriterLatch rwlatch_;
+
+  /** Versioned by every write latch, for optimistic readers. */
+  OptimisticLatch version_latch_;
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "common/rid.h"
@@ -84,6 +85,34 @@ class TablePage : public Page {
   auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager)
       -> bool;
 
+  /**
+   * Append a tuple without locking or logging it. Only for a page no other transaction can reach yet, e.g. one being
+   * filled by a bulk load.
+   * @param tuple tuple to insert
+   * @param[out] rid rid of the inserted tuple
+   * @return true if the insert is successful (i.e. there is enough space)
+   */
+  auto BulkInsertTuple(const Tuple &tuple, RID *rid) -> bool;
+
+  /** Remove every tuple from the page, keeping its place in the page list. */
+  void Clear() {
+    SetFreeSpacePointer(PAGE_SIZE);
+    SetTupleCount(0);
+  }
+
+  /**
+   * Drop the empty slots at the end of the slot array, giving their space back to inserts. The tuples themselves need
+   * no compaction: ApplyDelete() already closes the gap a tuple leaves.
+   * @return true if the page changed
+   */
+  auto Compact() -> bool;
+
+  /** @return true if the page has no slots left, i.e. every tuple on it was deleted and compacted away */
+  auto IsEmpty() -> bool { return GetTupleCount() == 0; }
+
+  /** Take away all free space of the page, so inserts that still find it after it was unlinked fail. */
+  void Seal() { SetFreeSpacePointer(SIZE_TABLE_PAGE_HEADER + SIZE_TUPLE * GetTupleCount()); }
+
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
    * @param rid rid of the tuple to mark as deleted
@@ -123,15 +152,25 @@ class TablePage : public Page {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool;
 
+  /** @return the number of free bytes between the slot array and the tuples */
+  auto GetFreeSpaceRemaining() -> uint32_t {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return the number of free bytes InsertTuple() needs for a tuple of tuple_size bytes, slot included */
+  static auto SpaceNeeded(uint32_t tuple_size) -> uint32_t { return tuple_size + SIZE_TUPLE; }
+
   /** @return the rid of the first tuple in this page */
 
   /**
+   * Safe to call under an optimistic read: a torn tuple count cannot make it read past the slot array.
    * @param[out] first_rid the RID of the first tuple in this page
    * @return true if the first tuple exists, false otherwise
    */
   auto GetFirstTupleRid(RID *first_rid) -> bool;
 
   /**
+   * Safe to call under an optimistic read: a torn tuple count cannot make it read past the slot array.
    * @param cur_rid the RID of the current tuple
    * @param[out] next_rid the RID of the tuple following the current tuple
    * @return true if the next tuple exists, false otherwise
@@ -149,6 +188,8 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
   static constexpr size_t OFFSET_TUPLE_OFFSET = 24;  // Naming things is hard.
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  /** No page has room for more slots than this. */
+  static constexpr uint32_t MAX_TUPLE_COUNT = (PAGE_SIZE - SIZE_TABLE_PAGE_HEADER) / SIZE_TUPLE;
 
   /** @return pointer to the end of the current free space, see header comment */
   auto GetFreeSpacePointer() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
@@ -164,13 +205,12 @@ class TablePage : public Page {
    */
   auto GetTupleCount() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
 
+  /** @return the tuple count, capped at the number of slots that fit in a page */
+  auto GetSlotCount() -> uint32_t { return std::min(GetTupleCount(), MAX_TUPLE_COUNT); }
+
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  auto GetFreeSpaceRemaining() -> uint32_t {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   /** @return tuple offset at slot slot_num */
   auto GetTupleOffsetAtSlot(uint32_t slot_num) -> uint32_t {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
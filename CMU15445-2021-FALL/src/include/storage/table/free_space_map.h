@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records how much free space every page of a table heap has, so an insert can go straight to a page
+ * with enough room instead of walking the heap's page list. It lives in its own pages (see FreeSpaceMapPage), in the
+ * order the heap pages were added.
+ *
+ * The map is a hint: it is not logged, and it can be stale while a heap page is being changed. Callers hold the heap
+ * page's write latch when they update its entry, and record what the page really has whenever a suggested page turns
+ * out to be too full, so a stale entry is not suggested again.
+ */
+class FreeSpaceMap {
+ public:
+  /** Free space is recorded in units of this many bytes. */
+  static constexpr uint32_t CATEGORY_SIZE = PAGE_SIZE / 256;
+
+  /**
+   * Create an empty free-space map.
+   * @param buffer_pool_manager the buffer pool manager
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  /**
+   * Open an existing free-space map. Reading stops at a page that does not carry its own page id, e.g. one that was
+   * never written back before a crash; the heap pages recorded from there on are no longer suggested, and a lost first
+   * page starts the map over empty.
+   * @param buffer_pool_manager the buffer pool manager
+   * @param first_page_id the id of the first page of the map
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id);
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /** @return the id of the first page of the map */
+  auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
+
+  /** @return the heap page added last, INVALID_PAGE_ID if the map is empty */
+  auto GetLastHeapPageId() -> page_id_t;
+
+  /** @return the heap pages recorded with less than CATEGORY_SIZE free bytes, in the order they were added */
+  auto GetFullPageIds() -> std::vector<page_id_t>;
+
+  /**
+   * Find a heap page that had at least size free bytes when its entry was last updated.
+   * @param size number of free bytes wanted
+   * @return the page id, INVALID_PAGE_ID if no page has enough room
+   */
+  auto FindPage(uint32_t size) -> page_id_t;
+
+  /**
+   * Record a new heap page.
+   * @param heap_page_id the id of the heap page
+   * @param free_space the page's free bytes
+   * @return false if the map could not grow, in which case the page is not suggested by FindPage()
+   */
+  auto AddPage(page_id_t heap_page_id, uint32_t free_space) -> bool;
+
+  /**
+   * Record the free space of a heap page. Pages the map does not know are ignored.
+   * @param heap_page_id the id of the heap page
+   * @param free_space the page's free bytes
+   */
+  void UpdatePage(page_id_t heap_page_id, uint32_t free_space);
+
+  /**
+   * Forget a heap page that was unlinked from the heap, and write the change back right away. Pages the map does not
+   * know are ignored.
+   * @param heap_page_id the id of the heap page
+   */
+  void RemovePage(page_id_t heap_page_id);
+
+  /** @return the category of a page with free_space free bytes */
+  static auto CategoryOf(uint32_t free_space) -> uint8_t;
+
+ private:
+  /** Where a heap page is recorded. */
+  struct Location {
+    size_t map_index_;
+    uint32_t slot_;
+  };
+
+  /** @return the id of the index-th page of the map, INVALID_PAGE_ID if there is none */
+  auto MapPageId(size_t index) -> page_id_t;
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+
+  /** Guards the members below, and serializes AddPage(). Never held while waiting for a heap page latch. */
+  std::mutex latch_;
+  /** The pages of the map, in list order */
+  std::vector<page_id_t> map_page_ids_;
+  std::unordered_map<page_id_t, Location> locations_;
+  page_id_t last_heap_page_id_{INVALID_PAGE_ID};
+
+  /** Index of the map page FindPage() starts at: the last one that had room, or that gained room. */
+  std::atomic<size_t> search_start_{0};
+};
+
+}  // namespace bustub
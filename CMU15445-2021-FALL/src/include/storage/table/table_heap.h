@@ -12,9 +12,21 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
 
@@ -22,23 +34,50 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages, plus a free-space map that points inserts to a page with room.
+ *
+ * New tuples go to one of NUM_TAILS tail pages, picked by a hash of the inserting thread, so concurrent inserters fill
+ * pages of their own and only meet when they append a page to the list. A tail page is recorded as full in the
+ * free-space map while it is being filled; what is left of it is recorded when its tail moves on to a new page.
+ *
+ * Vacuum() takes pages that all tuples were deleted from out of the list again, and gives their space back to the disk.
  */
 class TableHeap {
   friend class TableIterator;
 
  public:
-  ~TableHeap() = default;
+  /** Number of pages inserts fill at the same time. */
+  static constexpr size_t NUM_TAILS = 16;
+
+  /** What one call of Vacuum() did. */
+  struct VacuumStats {
+    /** Pages visited */
+    size_t pages_scanned_{0};
+    /** Pages that gave empty slots back to inserts */
+    size_t pages_compacted_{0};
+    /** Empty pages taken out of the list */
+    size_t pages_unlinked_{0};
+    /** Pages taken out of the list, by this call or an earlier one, that were deleted */
+    size_t pages_freed_{0};
+    /** True if the call reached the end of the list; the next call starts over from the first page */
+    bool finished_pass_{false};
+  };
+
+  ~TableHeap();
 
   /**
    * Create a table heap without a transaction. (open table)
+   * Pages appended after the free-space map was last written back are added to it, and pages it records as full are
+   * checked, since the tails' pages are recorded so while they are filled; without a map, a new one is built from the
+   * whole page list.
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param first_page_id the id of the first page
+   * @param free_space_map_page_id the id of the first page of the table's free-space map, INVALID_PAGE_ID if unknown
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            page_id_t first_page_id);
+            page_id_t first_page_id, page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
   /**
    * Create a table heap with a transaction. (create table)
@@ -59,6 +98,34 @@ class TableHeap {
    */
   auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
 
+  /**
+   * Load tuples into new pages, appended to the table in one step once they are full and written out in order. The
+   * tuples are neither locked nor logged one by one; the transaction gets a single write record, and an abort empties
+   * the pages. Meant for filling a table no other transaction uses yet, e.g. an initial load or an index rebuild.
+   * @param first the first tuple to insert
+   * @param last one past the last tuple to insert
+   * @param txn the transaction performing the insert
+   * @param[out] rids if not nullptr, the rids of the inserted tuples are appended to it
+   * @return true iff all tuples are inserted; on failure none are
+   */
+  template <typename TupleIterator>
+  auto BulkInsert(TupleIterator first, TupleIterator last, Transaction *txn, std::vector<RID> *rids = nullptr)
+      -> bool {
+    BulkLoad load;
+    const size_t num_rids = rids == nullptr ? 0 : rids->size();
+    for (; first != last; ++first) {
+      if (!BulkInsertTuple(*first, &load, txn, rids)) {
+        AbandonBulkInsert(&load);
+        if (rids != nullptr) {
+          rids->resize(num_rids);
+        }
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+    }
+    return FinishBulkInsert(&load, txn);
+  }
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param rid resource id of the tuple of delete
@@ -90,6 +157,20 @@ class TableHeap {
    */
   void RollbackDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Called on commit to make the free space left by a bulk insert available to other inserts.
+   * @param rid the rid of the bulk insert's write record
+   * @param txn transaction performing the commit
+   */
+  void CommitBulkInsert(const RID &rid, Transaction *txn);
+
+  /**
+   * Called on abort to rollback a bulk insert, emptying the pages it loaded.
+   * @param rid the rid of the bulk insert's write record
+   * @param txn transaction performing the rollback
+   */
+  void RollbackBulkInsert(const RID &rid, Transaction *txn);
+
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
@@ -99,20 +180,141 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy buffer access strategy for the pages read by the scan, nullptr to fetch them as usual
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
 
+  /**
+   * Reclaim the space of deleted tuples while the table is in use, visiting at most max_pages pages from where the
+   * previous call stopped. A page gives the empty slots at the end of its slot array back to inserts. A page left
+   * without tuples is taken out of the list, unless it is the first or last page or a tail is filling it, and is
+   * deleted once no insert or scan can still reach it.
+   * @param max_pages the most pages to visit
+   * @return what was done
+   */
+  auto Vacuum(size_t max_pages) -> VacuumStats;
+
+  /**
+   * Vacuum the table in the background, pages_per_round pages every interval, until StopVacuum(). Does nothing if the
+   * background vacuum is already running.
+   * @param interval time between two rounds
+   * @param pages_per_round the most pages to visit per round
+   */
+  void StartVacuum(std::chrono::milliseconds interval, size_t pages_per_round);
+
+  /** Stop the background vacuum, if it is running. */
+  void StopVacuum();
+
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the id of the first page of this table's free-space map, to open the table with */
+  inline auto GetFreeSpaceMapPageId() const -> page_id_t { return free_space_map_->GetFirstPageId(); }
+
  private:
+  /** A page that the inserts of a group of threads fill. Padded so tails do not share a cache line. */
+  struct alignas(64) Tail {
+    /** The page being filled, INVALID_PAGE_ID if the tail has to find a new one */
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+    /** Held shared by the inserts of the tail, so Vacuum() can wait until none is still on a page it unlinked */
+    std::shared_mutex latch_;
+  };
+
+  /** The pages a bulk insert has loaded so far; the last one is still write latched. */
+  struct BulkLoad {
+    std::vector<page_id_t> page_ids_;
+    WritePageGuard guard_;
+  };
+
+  /**
+   * Add a tuple to a bulk insert, starting a new page when the current one is full.
+   * @param tuple tuple to insert
+   * @param load the bulk insert
+   * @param txn the transaction performing the insert
+   * @param[out] rids if not nullptr, the rid of the inserted tuple is appended to it
+   * @return true iff the insert is successful
+   */
+  auto BulkInsertTuple(const Tuple &tuple, BulkLoad *load, Transaction *txn, std::vector<RID> *rids) -> bool;
+
+  /**
+   * Write out the pages of a bulk insert, link them to the end of the list and record the bulk insert.
+   * @param load the bulk insert
+   * @param txn the transaction performing the insert
+   * @return true iff the pages are part of the table
+   */
+  auto FinishBulkInsert(BulkLoad *load, Transaction *txn) -> bool;
+
+  /** Delete the pages of a bulk insert that failed. */
+  void AbandonBulkInsert(BulkLoad *load);
+
+  /**
+   * Append a new page to the list, insert a tuple into it and make it the tail's page.
+   * @param tuple tuple to insert
+   * @param[out] rid the rid of the inserted tuple
+   * @param txn the transaction performing the insert
+   * @param tail the tail of the inserting thread
+   * @return true iff the insert is successful
+   */
+  auto AppendPage(const Tuple &tuple, RID *rid, Transaction *txn, Tail *tail) -> bool;
+
+  /** @return true if a tail is filling the page */
+  auto IsTailPage(page_id_t page_id) -> bool;
+
+  /**
+   * Take an empty page out of the list, if it is still empty, not a tail page and between the same pages. The page
+   * keeps its own links, so a scan that is on it finds its way back to the list; it is deleted by FreeRetiredPages().
+   * @param prev_page_id the page before it
+   * @param page_id the page to unlink
+   * @param next_page_id the page after it
+   * @return true iff the page was unlinked
+   */
+  auto UnlinkPage(page_id_t prev_page_id, page_id_t page_id, page_id_t next_page_id) -> bool;
+
+  /**
+   * Delete the unlinked pages, once every insert that may have found one has finished and no scan is on the table.
+   * Pages that are still pinned are tried again by the next call.
+   * @return the number of pages deleted
+   */
+  auto FreeRetiredPages() -> size_t;
+
+  /** Background vacuum loop: runs Vacuum() every vacuum_interval_ until stop_vacuum_ is set. */
+  void RunVacuum();
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** Where the heap's pages come from, so they lie next to each other on disk and scans read them in order */
+  DiskExtent extent_;
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  /** Serializes appending pages */
+  std::mutex append_latch_;
+  /** The last page of the list; guarded by append_latch_ */
+  page_id_t last_page_id_{};
+  std::array<Tail, NUM_TAILS> tails_;
+  /** Number of iterators (and Begin() calls) on a page of this table; unlinked pages are not deleted while it is > 0 */
+  std::atomic<int> active_iterators_{0};
+
+  /** Serializes Vacuum() and guards the members below */
+  std::mutex vacuum_latch_;
+  /** The page the next Vacuum() starts at, INVALID_PAGE_ID for the first page */
+  page_id_t vacuum_page_id_{INVALID_PAGE_ID};
+  /** Pages taken out of the list but not deleted yet */
+  std::vector<page_id_t> retired_page_ids_;
+
+  std::thread vacuum_thread_;
+  /** Protects stop_vacuum_ and backs vacuum_cv_. */
+  std::mutex vacuum_thread_latch_;
+  std::condition_variable vacuum_cv_;
+  bool stop_vacuum_{false};
+  std::chrono::milliseconds vacuum_interval_{0};
+  size_t vacuum_pages_per_round_{0};
 };
 
 }  // namespace bustub
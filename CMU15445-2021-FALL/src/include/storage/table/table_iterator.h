@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -21,6 +22,7 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
@@ -30,12 +32,32 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * @param table_heap the table heap to scan
+   * @param rid the rid of the first tuple
+   * @param txn the transaction performing the scan
+   * @param strategy buffer access strategy for the pages read by the scan, nullptr to fetch them as usual
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        readahead_window_(other.readahead_window_),
+        pages_until_readahead_(other.pages_until_readahead_) {
+    if (IsOnPage()) {
+      EnterTable();
+    }
+  }
 
-  ~TableIterator() { delete tuple_; }
+  ~TableIterator() {
+    if (IsOnPage()) {
+      LeaveTable();
+    }
+    delete tuple_;
+  }
 
   inline auto operator==(const TableIterator &itr) const -> bool {
     return tuple_->rid_.Get() == itr.tuple_->rid_.Get();
@@ -52,16 +74,51 @@ class TableIterator {
   auto operator++(int) -> TableIterator;
 
   auto operator=(const TableIterator &other) -> TableIterator & {
+    if (other.IsOnPage()) {
+      other.EnterTable();
+    }
+    if (IsOnPage()) {
+      LeaveTable();
+    }
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    readahead_window_ = other.readahead_window_;
+    pages_until_readahead_ = other.pages_until_readahead_;
     return *this;
   }
 
  private:
+  /** Read-ahead starts with this many pages and doubles every time it is issued again. */
+  static constexpr size_t READAHEAD_MIN_PAGES = 4;
+  /** Read-ahead never covers more pages than this (nor more than half of the scan ring). */
+  static constexpr size_t READAHEAD_MAX_PAGES = 64;
+
+  /**
+   * Called when the scan moves onto a new page. Every half window, asks the buffer pool to prefetch the next
+   * readahead_window_ pages of the table, growing the window while the scan keeps going.
+   * @param next_page_id the page after the one the scan just moved onto, as read in a validated optimistic read
+   */
+  void ReadAhead(page_id_t next_page_id);
+
+  /** @return true if the iterator is on a page of its table, i.e. it is not the end iterator */
+  auto IsOnPage() const -> bool { return table_heap_ != nullptr && tuple_->rid_.GetPageId() != INVALID_PAGE_ID; }
+
+  /** Tell the table an iterator is on one of its pages, so it does not free pages the scan can still reach. */
+  void EnterTable() const;
+
+  /** Tell the table the iterator has left its pages. */
+  void LeaveTable() const;
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  BufferAccessStrategy *strategy_;
+  /** Number of pages covered by the last read-ahead (0 before the first one) */
+  size_t readahead_window_{0};
+  /** Pages left to move past before read-ahead is issued again */
+  size_t pages_until_readahead_{0};
 };
 
 }  // namespace bustub
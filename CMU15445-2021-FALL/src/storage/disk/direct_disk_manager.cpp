@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_disk_manager.cpp
+//
+// Identification: src/storage/disk/direct_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/direct_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+auto IsAligned(const char *buf) -> bool {
+  return reinterpret_cast<uintptr_t>(buf) % DirectDiskManager::DIRECT_IO_ALIGNMENT == 0;
+}
+
+/** Staging buffer for callers whose page buffer is not aligned for O_DIRECT; one per thread, so no latch is needed. */
+alignas(DirectDiskManager::DIRECT_IO_ALIGNMENT) thread_local char bounce_buffer[PAGE_SIZE];
+}  // namespace
+
+DirectDiskManager::DirectDiskManager(const std::string &db_file, bool use_io_uring) : DiskManager(db_file) {
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+  if (db_fd_ >= 0) {
+    direct_ = true;
+  } else if (errno == EINVAL) {
+    // the file system does not support O_DIRECT, go through the page cache instead
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+
+  if (use_io_uring) {
+    io_uring_ = std::make_unique<IoUring>(IO_URING_ENTRIES);
+    if (!io_uring_->IsValid()) {
+      LOG_DEBUG("io_uring is not available, falling back to pread/pwrite");
+      io_uring_.reset();
+    }
+  }
+}
+
+DirectDiskManager::~DirectDiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+}
+
+void DirectDiskManager::ShutDown() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+void DirectDiskManager::DeallocatePage(page_id_t page_id) {
+  if (db_fd_ >= 0) {
+    PunchHole(db_fd_, page_id);
+  }
+  space_manager_->DeallocatePage(page_id);
+}
+
+void DirectDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  space_manager_->SaveAllocation(page_id);
+  const uint64_t offset = static_cast<uint64_t>(page_id) * PAGE_SIZE;
+  num_writes_ += 1;
+  char *buf = const_cast<char *>(page_data);
+  if (!IsAligned(page_data)) {
+    memcpy(bounce_buffer, page_data, PAGE_SIZE);
+    buf = bounce_buffer;
+  }
+  if (Transfer(true, buf, offset) != PAGE_SIZE) {
+    LOG_DEBUG("I/O error while writing");
+  }
+}
+
+void DirectDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  const uint64_t offset = static_cast<uint64_t>(page_id) * PAGE_SIZE;
+  char *buf = IsAligned(page_data) ? page_data : bounce_buffer;
+  int read_count = Transfer(false, buf, offset);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    memset(buf + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (buf != page_data) {
+    memcpy(page_data, buf, PAGE_SIZE);
+  }
+}
+
+void DirectDiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> *pages) {
+  for (const auto &page : *pages) {
+    space_manager_->SaveAllocation(page.first);
+  }
+  const auto runs = CoalescePages(pages);
+  // Runs that are scattered in memory or not aligned are copied to their own slice of an aligned staging area.
+  std::unique_ptr<char, decltype(&free)> staging(nullptr, &free);
+  std::vector<IoUring::Request> requests(runs.size());
+  for (size_t i = 0; i < runs.size(); i++) {
+    const auto &run = runs[i];
+    const char *data = pages->at(run.first).second;
+    if (!IsAligned(data) || !IsContiguous(*pages, run)) {
+      if (staging == nullptr) {
+        staging.reset(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, pages->size() * PAGE_SIZE)));
+      }
+      char *slice = staging.get() + run.first * PAGE_SIZE;
+      for (size_t j = run.first; j < run.second; j++) {
+        memcpy(slice + (j - run.first) * PAGE_SIZE, pages->at(j).second, PAGE_SIZE);
+      }
+      data = slice;
+    }
+    requests[i].write_ = true;
+    requests[i].fd_ = db_fd_;
+    requests[i].buf_ = const_cast<char *>(data);
+    requests[i].len_ = static_cast<uint32_t>((run.second - run.first) * PAGE_SIZE);
+    requests[i].offset_ = static_cast<uint64_t>(pages->at(run.first).first) * PAGE_SIZE;
+  }
+  num_writes_ += static_cast<int>(pages->size());
+
+  if (io_uring_ != nullptr) {
+    io_uring_->Execute(requests.data(), requests.size());
+  }
+  for (auto &request : requests) {
+    // Short writes are finished, and failed ones redone, with pwrite, which reports an error that persists.
+    ssize_t written = io_uring_ != nullptr ? std::max(request.result_, 0) : 0;
+    if (written < static_cast<ssize_t>(request.len_)) {
+      written = TransferRest(true, request.buf_, request.len_, request.offset_, written);
+    }
+    if (written != static_cast<ssize_t>(request.len_)) {
+      LOG_DEBUG("I/O error while writing");
+    }
+  }
+}
+
+auto DirectDiskManager::Transfer(bool write, char *buf, uint64_t offset) -> int {
+  size_t done = 0;
+  if (io_uring_ != nullptr) {
+    IoUring::Request request;
+    request.write_ = write;
+    request.fd_ = db_fd_;
+    request.buf_ = buf;
+    request.len_ = PAGE_SIZE;
+    request.offset_ = offset;
+    io_uring_->Execute(&request, 1);
+    // a short read means the end of the file; finish a short write, or redo a failed request, below
+    if (request.result_ >= 0 && (!write || request.result_ == PAGE_SIZE)) {
+      return request.result_;
+    }
+    done = std::max(request.result_, 0);
+  }
+  return static_cast<int>(TransferRest(write, buf, PAGE_SIZE, offset, done));
+}
+
+auto DirectDiskManager::TransferRest(bool write, char *buf, size_t len, uint64_t offset, size_t done) -> ssize_t {
+  while (done < len) {
+    ssize_t n = write ? pwrite(db_fd_, buf + done, len - done, offset + done)
+                      : pread(db_fd_, buf + done, len - done, offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -errno;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+}  // namespace bustub
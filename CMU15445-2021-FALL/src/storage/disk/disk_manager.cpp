@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -31,10 +34,11 @@ static char *buffer_used;
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+    : file_name_(db_file), num_writes_(0), num_flushes_(0), flush_log_(false), flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
+    space_manager_ = std::make_unique<DiskSpaceManager>("", 0);
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
@@ -67,16 +71,34 @@ DiskManager::DiskManager(const std::string &db_file)
       throw Exception("can't open db file");
     }
   }
+  hole_fd_ = open(db_file.c_str(), O_WRONLY);
+  if (hole_fd_ < 0) {
+    LOG_DEBUG("can't open db file to punch holes, deallocated pages keep their space");
+  }
+  const int db_size = GetFileSize(db_file);
+  const auto num_db_pages = static_cast<page_id_t>((std::max(db_size, 0) + PAGE_SIZE - 1) / PAGE_SIZE);
+  space_manager_ = std::make_unique<DiskSpaceManager>(file_name_.substr(0, n) + ".space", num_db_pages);
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (hole_fd_ >= 0) {
+    close(hole_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  space_manager_->Save();
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
+    if (hole_fd_ >= 0) {
+      close(hole_fd_);
+      hole_fd_ = -1;
+    }
   }
   log_io_.close();
 }
@@ -86,6 +108,7 @@ void DiskManager::ShutDown() {
  * ָҳдļ
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  space_manager_->SaveAllocation(page_id);
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
   // set write cursor to offset
@@ -101,6 +124,31 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * Punch a hole over a page of the database file, then free the page
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    // Buffered writes must reach the file first, or they would fill the hole in again.
+    db_io_.flush();
+    if (hole_fd_ >= 0) {
+      PunchHole(hole_fd_, page_id);
+    }
+  }
+  // Only now may the page be handed out again, so the hole cannot swallow a write of its next owner.
+  space_manager_->DeallocatePage(page_id);
+}
+
+void DiskManager::PunchHole(int fd, page_id_t page_id) {
+#ifdef FALLOC_FL_PUNCH_HOLE
+  const off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, PAGE_SIZE) != 0) {
+    LOG_DEBUG("could not punch a hole for a deallocated page");
+  }
+#endif
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
@@ -130,6 +178,64 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Write a batch of pages, one write per run of adjacent pages
+ */
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> *pages) {
+  for (const auto &page : *pages) {
+    space_manager_->SaveAllocation(page.first);
+  }
+  std::vector<char> staging(MAX_COALESCED_PAGES * PAGE_SIZE);
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  for (const auto &run : CoalescePages(pages)) {
+    size_t offset = static_cast<size_t>((*pages)[run.first].first) * PAGE_SIZE;
+    num_writes_ += static_cast<int>(run.second - run.first);
+    db_io_.seekp(offset);
+    db_io_.write(RunData(*pages, run, staging.data()), (run.second - run.first) * PAGE_SIZE);
+    if (db_io_.bad()) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+  }
+  db_io_.flush();
+}
+
+auto DiskManager::CoalescePages(std::vector<std::pair<page_id_t, const char *>> *pages)
+    -> std::vector<std::pair<size_t, size_t>> {
+  std::sort(pages->begin(), pages->end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<std::pair<size_t, size_t>> runs;
+  for (size_t i = 0; i < pages->size(); i++) {
+    if (runs.empty() || (*pages)[i].first != (*pages)[i - 1].first + 1 ||
+        i - runs.back().first == MAX_COALESCED_PAGES) {
+      runs.emplace_back(i, i + 1);
+    } else {
+      runs.back().second = i + 1;
+    }
+  }
+  return runs;
+}
+
+auto DiskManager::IsContiguous(const std::vector<std::pair<page_id_t, const char *>> &pages,
+                               std::pair<size_t, size_t> run) -> bool {
+  for (size_t i = run.first + 1; i < run.second; i++) {
+    if (pages[i].second != pages[run.first].second + (i - run.first) * PAGE_SIZE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto DiskManager::RunData(const std::vector<std::pair<page_id_t, const char *>> &pages, std::pair<size_t, size_t> run,
+                          char *staging) -> const char * {
+  if (IsContiguous(pages, run)) {
+    return pages[run.first].second;
+  }
+  for (size_t i = run.first; i < run.second; i++) {
+    memcpy(staging + (i - run.first) * PAGE_SIZE, pages[i].second, PAGE_SIZE);
+  }
+  return staging;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -0,0 +1,242 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_space_manager.cpp
+//
+// Identification: src/storage/disk/disk_space_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_space_manager.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskSpaceManager::DiskSpaceManager(const std::string &file_name, page_id_t num_db_pages) : file_name_(file_name) {
+  if (!file_name_.empty()) {
+    const auto mode = std::ios::binary | std::ios::in | std::ios::out;
+    // A new database file starts a new bitmap, whatever an old one says.
+    if (num_db_pages > 0) {
+      file_.open(file_name_, mode);
+    }
+    if (file_.is_open()) {
+      size_t words = 0;
+      for (;;) {
+        allocated_.resize(words + WORDS_PER_CHUNK);
+        if (!file_.read(reinterpret_cast<char *>(&allocated_[words]), PAGE_SIZE)) {
+          break;
+        }
+        words += WORDS_PER_CHUNK;
+      }
+      // A chunk cut short by a crash is padded with zeros, i.e. free pages, which are not on disk yet either.
+      if (file_.gcount() == 0) {
+        allocated_.resize(words);
+      }
+      file_.clear();
+    } else {
+      file_.clear();
+      // create a new file
+      file_.open(file_name_, std::ios::binary | std::ios::trunc | std::ios::out);
+      file_.close();
+      // reopen with original mode
+      file_.open(file_name_, mode);
+      if (!file_.is_open()) {
+        throw Exception("can't open space map file");
+      }
+    }
+  }
+  const size_t num_chunks = allocated_.size() / WORDS_PER_CHUNK;
+  reserved_.resize(allocated_.size());
+  dirty_chunks_.resize(num_chunks);
+  unsaved_allocations_.resize(num_chunks);
+  if (num_chunks == 0) {
+    // Without a saved bitmap, every page the database file has is taken to be in use.
+    for (page_id_t page_id = 0; page_id < num_db_pages; page_id++) {
+      MarkAllocated(page_id);
+    }
+  }
+  first_free_ = FindFree(0);
+}
+
+DiskSpaceManager::~DiskSpaceManager() { Save(); }
+
+auto DiskSpaceManager::AllocatePage(const PageFilter &usable) -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  page_id_t page_id = FindFree(first_free_);
+  while (!usable(page_id)) {
+    page_id = FindFree(page_id + 1);
+  }
+  MarkAllocated(page_id);
+  first_free_ = FindFree(first_free_);
+  return page_id;
+}
+
+auto DiskSpaceManager::AllocatePage(DiskExtent *extent, const PageFilter &usable) -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  // The rest of the caller's extent comes first.
+  if (extent->next_page_id_ != INVALID_PAGE_ID) {
+    for (page_id_t page_id = extent->next_page_id_; page_id < extent->end_page_id_; page_id++) {
+      if (!TestBit(allocated_, page_id) && usable(page_id)) {
+        MarkAllocated(page_id);
+        extent->next_page_id_ = page_id + 1;
+        return page_id;
+      }
+    }
+  }
+  Unreserve(extent);
+  // Then the lowest extent with a free page: holes are filled before the file grows, and past its end every extent is
+  // free.
+  page_id_t first = first_free_ / EXTENT_SIZE * EXTENT_SIZE;
+  uint64_t free_pages;
+  while ((free_pages = FreePagesOf(first, usable)) == 0) {
+    first += EXTENT_SIZE;
+  }
+  return Reserve(extent, first, free_pages);
+}
+
+void DiskSpaceManager::ReleaseExtent(DiskExtent *extent) {
+  std::lock_guard<std::mutex> lock(latch_);
+  Unreserve(extent);
+}
+
+void DiskSpaceManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (page_id < 0 || !TestBit(allocated_, page_id)) {
+    return;
+  }
+  allocated_[page_id / BITS_PER_WORD] &= ~(uint64_t{1} << (page_id % BITS_PER_WORD));
+  dirty_chunks_[page_id / PAGES_PER_CHUNK] = true;
+  if (!IsTaken(page_id)) {
+    first_free_ = std::min(first_free_, page_id);
+  }
+}
+
+auto DiskSpaceManager::IsAllocated(page_id_t page_id) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  return page_id >= 0 && TestBit(allocated_, page_id);
+}
+
+void DiskSpaceManager::SaveAllocation(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  const size_t chunk = page_id / PAGES_PER_CHUNK;
+  if (chunk < unsaved_allocations_.size() && unsaved_allocations_[chunk]) {
+    WriteChunk(chunk);
+  }
+}
+
+void DiskSpaceManager::Save() {
+  std::lock_guard<std::mutex> lock(latch_);
+  for (size_t chunk = 0; chunk < dirty_chunks_.size(); chunk++) {
+    if (dirty_chunks_[chunk]) {
+      WriteChunk(chunk);
+    }
+  }
+}
+
+auto DiskSpaceManager::TestBit(const std::vector<uint64_t> &bits, page_id_t page_id) -> bool {
+  const size_t word = static_cast<size_t>(page_id) / BITS_PER_WORD;
+  return word < bits.size() && (bits[word] >> (page_id % BITS_PER_WORD) & 1) != 0;
+}
+
+auto DiskSpaceManager::IsTaken(page_id_t page_id) const -> bool {
+  return TestBit(allocated_, page_id) || TestBit(reserved_, page_id);
+}
+
+auto DiskSpaceManager::FindFree(page_id_t from) const -> page_id_t {
+  size_t word = static_cast<size_t>(from) / BITS_PER_WORD;
+  if (word >= allocated_.size()) {
+    return from;
+  }
+  // The pages below from count as taken.
+  uint64_t taken = allocated_[word] | reserved_[word] | ((uint64_t{1} << (from % BITS_PER_WORD)) - 1);
+  while (taken == ~uint64_t{0}) {
+    if (++word == allocated_.size()) {
+      return static_cast<page_id_t>(word * BITS_PER_WORD);
+    }
+    taken = allocated_[word] | reserved_[word];
+  }
+  return static_cast<page_id_t>(word * BITS_PER_WORD + __builtin_ctzll(~taken));
+}
+
+auto DiskSpaceManager::FreePagesOf(page_id_t first, const PageFilter &usable) const -> uint64_t {
+  static_assert(BITS_PER_WORD % EXTENT_SIZE == 0, "An extent must not straddle two words of the bitmap.");
+  const size_t word = static_cast<size_t>(first) / BITS_PER_WORD;
+  const size_t shift = first % BITS_PER_WORD;
+  uint64_t free_pages = EXTENT_MASK;
+  if (word < allocated_.size()) {
+    if ((reserved_[word] >> shift & EXTENT_MASK) != 0) {
+      return 0;
+    }
+    free_pages &= ~(allocated_[word] >> shift);
+  }
+  for (uint32_t i = 0; i < EXTENT_SIZE; i++) {
+    if ((free_pages >> i & 1) != 0 && !usable(first + static_cast<page_id_t>(i))) {
+      free_pages &= ~(uint64_t{1} << i);
+    }
+  }
+  return free_pages;
+}
+
+void DiskSpaceManager::Grow(page_id_t page_id) {
+  const size_t num_chunks = page_id / PAGES_PER_CHUNK + 1;
+  if (num_chunks > dirty_chunks_.size()) {
+    allocated_.resize(num_chunks * WORDS_PER_CHUNK);
+    reserved_.resize(num_chunks * WORDS_PER_CHUNK);
+    dirty_chunks_.resize(num_chunks);
+    unsaved_allocations_.resize(num_chunks);
+  }
+}
+
+void DiskSpaceManager::MarkAllocated(page_id_t page_id) {
+  Grow(page_id);
+  allocated_[page_id / BITS_PER_WORD] |= uint64_t{1} << (page_id % BITS_PER_WORD);
+  dirty_chunks_[page_id / PAGES_PER_CHUNK] = true;
+  unsaved_allocations_[page_id / PAGES_PER_CHUNK] = true;
+}
+
+auto DiskSpaceManager::Reserve(DiskExtent *extent, page_id_t first, uint64_t free_pages) -> page_id_t {
+  Grow(first + EXTENT_SIZE - 1);
+  reserved_[first / BITS_PER_WORD] |= free_pages << (first % BITS_PER_WORD);
+  const page_id_t page_id = first + __builtin_ctzll(free_pages);
+  MarkAllocated(page_id);
+  extent->next_page_id_ = page_id + 1;
+  extent->end_page_id_ = first + EXTENT_SIZE;
+  first_free_ = FindFree(first_free_);
+  return page_id;
+}
+
+void DiskSpaceManager::Unreserve(DiskExtent *extent) {
+  if (extent->next_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  // The owner of an extent is the only one with reserved pages in it.
+  const page_id_t first = extent->end_page_id_ - EXTENT_SIZE;
+  reserved_[first / BITS_PER_WORD] &= ~(EXTENT_MASK << (first % BITS_PER_WORD));
+  first_free_ = std::min(first_free_, FindFree(first));
+  extent->next_page_id_ = INVALID_PAGE_ID;
+  extent->end_page_id_ = INVALID_PAGE_ID;
+}
+
+void DiskSpaceManager::WriteChunk(size_t chunk) {
+  dirty_chunks_[chunk] = false;
+  unsaved_allocations_[chunk] = false;
+  if (!file_.is_open()) {
+    return;
+  }
+  file_.seekp(chunk * PAGE_SIZE);
+  file_.write(reinterpret_cast<const char *>(&allocated_[chunk * WORDS_PER_CHUNK]), PAGE_SIZE);
+  if (file_.bad()) {
+    LOG_DEBUG("I/O error while writing the space map");
+    return;
+  }
+  file_.flush();
+}
+
+}  // namespace bustub
@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.cpp
+//
+// Identification: src/storage/disk/io_uring.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+auto IoUringSetup(uint32_t entries, io_uring_params *params) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+auto IoUringEnter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+auto IoUringRegister(int ring_fd, uint32_t opcode, void *arg, uint32_t nr_args) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+/** @return true if the ring supports IORING_OP_READ and IORING_OP_WRITE; kernels before 5.6 know neither. */
+auto SupportsReadWrite(int ring_fd) -> bool {
+  constexpr uint32_t num_ops = IORING_OP_WRITE + 1;
+  alignas(io_uring_probe) char buf[sizeof(io_uring_probe) + num_ops * sizeof(io_uring_probe_op)] = {};
+  auto *probe = reinterpret_cast<io_uring_probe *>(buf);
+  // The probe itself is as old as the two operations, so a kernel that does not know it does not have them either.
+  if (IoUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, num_ops) < 0 || probe->last_op < IORING_OP_WRITE) {
+    return false;
+  }
+  return (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0 &&
+         (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+template <typename T>
+auto RingField(void *ring, uint32_t offset) -> T * {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+}  // namespace
+
+IoUring::IoUring(uint32_t entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = IoUringSetup(entries, &params);
+  if (ring_fd < 0) {
+    return;
+  }
+  if (!SupportsReadWrite(ring_fd)) {
+    close(ring_fd);
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  auto map_ring = [ring_fd](size_t size, off_t offset) {
+    return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+  };
+  sq_ring_ = map_ring(sq_ring_size_, IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_ : map_ring(cq_ring_size_, IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = map_ring(sqes_size_, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (!single_mmap && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sqes != MAP_FAILED) {
+      munmap(sqes, sqes_size_);
+    }
+    close(ring_fd);
+    return;
+  }
+
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+  sq_tail_ = RingField<unsigned>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = RingField<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingField<unsigned>(sq_ring_, params.sq_off.array);
+  cq_head_ = RingField<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField<unsigned>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = RingField<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = RingField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+  sq_entries_ = params.sq_entries;
+  ring_fd_ = ring_fd;
+}
+
+IoUring::~IoUring() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+void IoUring::Execute(Request *requests, size_t count) {
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t pushed = 0;
+  while (true) {
+    uint32_t to_submit = 0;
+    while (pushed < count && in_flight_ < sq_entries_) {
+      Push(&requests[pushed++]);
+      to_submit++;
+    }
+    if (to_submit > 0) {
+      Submit(to_submit);
+    }
+
+    if (pushed == count && std::all_of(requests, requests + count, [](const Request &r) { return r.done_; })) {
+      return;
+    }
+
+    // Someone else is already waiting for completions and will wake us up.
+    if (reaping_) {
+      cv_.wait(lock);
+      continue;
+    }
+    reaping_ = true;
+    lock.unlock();
+    IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    lock.lock();
+    Reap();
+    reaping_ = false;
+    cv_.notify_all();
+  }
+}
+
+void IoUring::Push(Request *request) {
+  const unsigned tail = *sq_tail_;
+  const unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = request->write_ ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = request->fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(request->buf_);
+  sqe->len = request->len_;
+  sqe->off = request->offset_;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  request->done_ = false;
+  // Publish the entry before the kernel can see the new tail.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  in_flight_++;
+}
+
+void IoUring::Submit(uint32_t count) {
+  while (count > 0) {
+    const int submitted = IoUringEnter(ring_fd_, count, 0, 0);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      throw Exception("io_uring_enter failed");
+    }
+    count -= submitted;
+  }
+}
+
+void IoUring::Reap() {
+  unsigned head = *cq_head_;
+  const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++) {
+    const io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+    auto *request = reinterpret_cast<Request *>(cqe->user_data);
+    request->result_ = cqe->res;
+    request->done_ = true;
+    in_flight_--;
+  }
+  // Hand the consumed entries back to the kernel.
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+}  // namespace bustub
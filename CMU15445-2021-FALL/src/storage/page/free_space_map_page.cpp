@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.cpp
+//
+// Identification: src/storage/page/free_space_map_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/free_space_map_page.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void FreeSpaceMapPage::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  next_page_id_ = INVALID_PAGE_ID;
+  count_ = 0;
+  max_category_ = 0;
+}
+
+auto FreeSpaceMapPage::Append(page_id_t heap_page_id, uint8_t category) -> uint32_t {
+  BUSTUB_ASSERT(!IsFull(), "cannot append to a full free-space map page");
+  heap_page_ids_[count_] = heap_page_id;
+  categories_[count_] = category;
+  max_category_ = std::max(max_category_, category);
+  return count_++;
+}
+
+void FreeSpaceMapPage::SetCategory(uint32_t slot, uint8_t category) {
+  BUSTUB_ASSERT(slot < count_, "slot out of range");
+  const uint8_t old_category = categories_[slot];
+  categories_[slot] = category;
+  if (category > max_category_) {
+    max_category_ = category;
+  } else if (old_category == max_category_ && category < old_category) {
+    // The page may have lost its largest category; a scan of one byte per slot finds the new one.
+    max_category_ = *std::max_element(categories_, categories_ + count_);
+  }
+}
+
+void FreeSpaceMapPage::ClearSlot(uint32_t slot) {
+  SetCategory(slot, 0);
+  heap_page_ids_[slot] = INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMapPage::FindSlot(uint8_t category) const -> uint32_t {
+  if (category > max_category_) {
+    return count_;
+  }
+  return std::find_if(categories_, categories_ + count_, [category](uint8_t c) { return c >= category; }) -
+         categories_;
+}
+
+}  // namespace bustub
@@ -47,6 +47,10 @@ uint32_t HashTableDirectoryPage::GetGlobalDepthMask() {
 //һתλΪŵĹܡGetSplitImageIndex(101) = 001; 
 //GetSplitImageIndex(001) = 101
 //GetLocalHighBit() ȡλ
+uint32_t HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) {
+  return (1U << local_depths_[bucket_idx]) - 1;
+}
+
 uint32_t HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) {  // õͰӦͰͰλ÷
     uint32_t local_depth = GetLocalDepth(bucket_idx);
     uint32_t local_mask = GetLocalDepthMask(bucket_idx);
@@ -85,6 +85,34 @@ auto TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   return true;
 }
 
+auto TablePage::BulkInsertTuple(const Tuple &tuple, RID *rid) -> bool {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
+    return false;
+  }
+  // A page being loaded has no empty slots to reuse, so the tuple always gets a new slot at the end.
+  const uint32_t slot_num = GetTupleCount();
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size_);
+  SetTupleCount(slot_num + 1);
+  rid->Set(GetTablePageId(), slot_num);
+  return true;
+}
+
+auto TablePage::Compact() -> bool {
+  uint32_t tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    tuple_count--;
+  }
+  if (tuple_count == GetTupleCount()) {
+    return false;
+  }
+  SetTupleCount(tuple_count);
+  return true;
+}
+
 auto TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager)
     -> bool {
   uint32_t slot_num = rid.GetSlotNum();
@@ -308,7 +336,7 @@ auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
 
 auto TablePage::GetFirstTupleRid(RID *first_rid) -> bool {
   // Find and return the first valid tuple.
-  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
+  for (uint32_t i = 0; i < GetSlotCount(); ++i) {
     if (!IsDeleted(GetTupleSize(i))) {
       first_rid->Set(GetTablePageId(), i);
       return true;
@@ -321,7 +349,7 @@ auto TablePage::GetFirstTupleRid(RID *first_rid) -> bool {
 auto TablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool {
   BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
-  for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetSlotCount(); ++i) {
     if (!IsDeleted(GetTupleSize(i))) {
       next_rid->Set(GetTablePageId(), i);
       return true;
@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(&first_page_id_);
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't create a page for the free-space map.");
+  guard.AsMut<FreeSpaceMapPage>()->Init(first_page_id_);
+  map_page_ids_.push_back(first_page_id_);
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {
+  page_id_t map_page_id = first_page_id;
+  while (map_page_id != INVALID_PAGE_ID) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(map_page_id);
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't fetch a page of the free-space map.");
+    const auto *map_page = guard.As<FreeSpaceMapPage>();
+    if (map_page->GetPageId() != map_page_id) {
+      break;
+    }
+    const size_t map_index = map_page_ids_.size();
+    map_page_ids_.push_back(map_page_id);
+    for (uint32_t slot = 0; slot < map_page->GetCount(); slot++) {
+      const page_id_t heap_page_id = map_page->GetHeapPageId(slot);
+      if (heap_page_id == INVALID_PAGE_ID) {
+        continue;
+      }
+      last_heap_page_id_ = heap_page_id;
+      locations_[heap_page_id] = {map_index, slot};
+    }
+    map_page_id = map_page->GetNextPageId();
+  }
+  if (map_page_ids_.empty()) {
+    // Even the first page was lost; start over with an empty map.
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(first_page_id);
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't fetch the first page of the free-space map.");
+    guard.AsMut<FreeSpaceMapPage>()->Init(first_page_id);
+    map_page_ids_.push_back(first_page_id);
+  }
+}
+
+auto FreeSpaceMap::GetLastHeapPageId() -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return last_heap_page_id_;
+}
+
+auto FreeSpaceMap::GetFullPageIds() -> std::vector<page_id_t> {
+  std::vector<page_id_t> full_page_ids;
+  std::lock_guard<std::mutex> lock(latch_);
+  for (const page_id_t map_page_id : map_page_ids_) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(map_page_id);
+    if (!guard.IsValid()) {
+      break;
+    }
+    const auto *map_page = guard.As<FreeSpaceMapPage>();
+    for (uint32_t slot = 0; slot < map_page->GetCount(); slot++) {
+      if (map_page->GetHeapPageId(slot) != INVALID_PAGE_ID && map_page->GetCategory(slot) == 0) {
+        full_page_ids.push_back(map_page->GetHeapPageId(slot));
+      }
+    }
+  }
+  return full_page_ids;
+}
+
+auto FreeSpaceMap::FindPage(uint32_t size) -> page_id_t {
+  const uint32_t category = (size + CATEGORY_SIZE - 1) / CATEGORY_SIZE;
+  if (category > UINT8_MAX) {
+    return INVALID_PAGE_ID;
+  }
+  const size_t start = search_start_.load(std::memory_order_relaxed);
+  size_t num_map_pages;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    num_map_pages = map_page_ids_.size();
+  }
+  for (size_t i = 0; i < num_map_pages; i++) {
+    const size_t map_index = (start + i) % num_map_pages;
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(MapPageId(map_index));
+    if (!guard.IsValid()) {
+      return INVALID_PAGE_ID;
+    }
+    const auto *map_page = guard.As<FreeSpaceMapPage>();
+    const uint32_t slot = map_page->FindSlot(category);
+    if (slot < map_page->GetCount()) {
+      search_start_.store(map_index, std::memory_order_relaxed);
+      return map_page->GetHeapPageId(slot);
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMap::AddPage(page_id_t heap_page_id, uint32_t free_space) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_page_ids_.back());
+  if (!guard.IsValid()) {
+    return false;
+  }
+  if (guard.As<FreeSpaceMapPage>()->IsFull()) {
+    page_id_t new_map_page_id;
+    WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_map_page_id);
+    if (!new_guard.IsValid()) {
+      return false;
+    }
+    new_guard.AsMut<FreeSpaceMapPage>()->Init(new_map_page_id);
+    guard.AsMut<FreeSpaceMapPage>()->SetNextPageId(new_map_page_id);
+    map_page_ids_.push_back(new_map_page_id);
+    guard = std::move(new_guard);
+  }
+  const uint32_t slot = guard.AsMut<FreeSpaceMapPage>()->Append(heap_page_id, CategoryOf(free_space));
+  locations_[heap_page_id] = {map_page_ids_.size() - 1, slot};
+  last_heap_page_id_ = heap_page_id;
+  // A new page is where the next inserts will find room.
+  search_start_.store(map_page_ids_.size() - 1, std::memory_order_relaxed);
+  return true;
+}
+
+void FreeSpaceMap::UpdatePage(page_id_t heap_page_id, uint32_t free_space) {
+  Location location;
+  page_id_t map_page_id;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto entry = locations_.find(heap_page_id);
+    if (entry == locations_.end()) {
+      return;
+    }
+    location = entry->second;
+    map_page_id = map_page_ids_[location.map_index_];
+  }
+  const uint8_t category = CategoryOf(free_space);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_page_id);
+  if (!guard.IsValid()) {
+    return;
+  }
+  auto *map_page = guard.As<FreeSpaceMapPage>();
+  if (map_page->GetCategory(location.slot_) == category) {
+    // Small changes leave a page in its category and do not need to dirty the map page.
+    return;
+  }
+  if (category > map_page->GetCategory(location.slot_)) {
+    search_start_.store(location.map_index_, std::memory_order_relaxed);
+  }
+  guard.AsMut<FreeSpaceMapPage>()->SetCategory(location.slot_, category);
+}
+
+void FreeSpaceMap::RemovePage(page_id_t heap_page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto entry = locations_.find(heap_page_id);
+  if (entry == locations_.end()) {
+    return;
+  }
+  const Location location = entry->second;
+  locations_.erase(entry);
+  // UpdatePage() never waits for latch_ while it holds a map page latch, so this cannot deadlock.
+  const page_id_t map_page_id = map_page_ids_[location.map_index_];
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(map_page_id);
+  if (!guard.IsValid()) {
+    return;
+  }
+  guard.AsMut<FreeSpaceMapPage>()->ClearSlot(location.slot_);
+  guard.Drop();
+  // The heap page is about to be freed; a map read back from disk must not suggest it again. The flush takes the map
+  // page's read latch, so it writes out an image no update is halfway through.
+  buffer_pool_manager_->FlushPage(map_page_id);
+}
+
+auto FreeSpaceMap::CategoryOf(uint32_t free_space) -> uint8_t {
+  return static_cast<uint8_t>(std::min<uint32_t>(free_space / CATEGORY_SIZE, UINT8_MAX));
+}
+
+auto FreeSpaceMap::MapPageId(size_t index) -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return index < map_page_ids_.size() ? map_page_ids_[index] : INVALID_PAGE_ID;
+}
+
+}  // namespace bustub
@@ -10,7 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -18,22 +26,61 @@
 namespace bustub {
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     page_id_t first_page_id)
+                     page_id_t first_page_id, page_id_t free_space_map_page_id)
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id) {
+  if (free_space_map_page_id == INVALID_PAGE_ID) {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+  } else {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, free_space_map_page_id);
+  }
+  // The pages the tails were filling when the table was closed are recorded as full; record what they really have.
+  for (const page_id_t full_page_id : free_space_map_->GetFullPageIds()) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(full_page_id);
+    if (guard.IsValid()) {
+      free_space_map_->UpdatePage(full_page_id, guard.As<TablePage>()->GetFreeSpaceRemaining());
+    }
+  }
+  // Find the last page, starting from the last one the map knows, and record the pages the map is missing.
+  page_id_t page_id = free_space_map_->GetLastHeapPageId();
+  bool is_recorded = page_id != INVALID_PAGE_ID;
+  if (!is_recorded) {
+    page_id = first_page_id_;
+  }
+  while (true) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't fetch a page of the table heap.");
+    auto *page = guard.As<TablePage>();
+    if (!is_recorded) {
+      free_space_map_->AddPage(page_id, page->GetFreeSpaceRemaining());
+    }
+    is_recorded = false;
+    if (page->GetNextPageId() == INVALID_PAGE_ID) {
+      break;
+    }
+    page_id = page->GetNextPageId();
+  }
+  last_page_id_ = page_id;
+}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
                      Transaction *txn)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
   // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
-  BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
-  first_page->WLatch();
+  WritePageGuard first_guard = buffer_pool_manager_->NewPageGuarded(&first_page_id_, &extent_);
+  BUSTUB_ASSERT(first_guard.IsValid(), "Couldn't create a page for the table heap.");
+  auto *first_page = first_guard.AsMut<TablePage>();
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
-  first_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+  free_space_map_->AddPage(first_page_id_, first_page->GetFreeSpaceRemaining());
+  last_page_id_ = first_page_id_;
+}
+
+TableHeap::~TableHeap() {
+  StopVacuum();
+  buffer_pool_manager_->ReleaseExtent(&extent_);
 }
 
 auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
@@ -42,68 +89,179 @@ auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> b
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  // First try the page this thread's tail is filling.
+  Tail &tail = tails_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_TAILS];
+  std::shared_lock<std::shared_mutex> tail_lock(tail.latch_);
+  page_id_t page_id = tail.page_id_.load();
+  if (page_id != INVALID_PAGE_ID) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (guard.IsValid()) {
+      auto *page = guard.As<TablePage>();
+      if (page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
+        guard.MarkDirty();
+        guard.Drop();
+        // Update the transaction's write set.
+        txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+        return true;
+      }
+      // The page is full. What is left of it goes back to the free-space map, and the tail moves on.
+      free_space_map_->UpdatePage(page_id, page->GetFreeSpaceRemaining());
+      tail.page_id_.compare_exchange_strong(page_id, INVALID_PAGE_ID);
+    }
+  }
+
+  // Then a page the free-space map says has enough space. Every page tried has its entry corrected, so a page that
+  // turns out to be too full is not suggested again.
+  const uint32_t space_needed = TablePage::SpaceNeeded(tuple.size_);
+  while ((page_id = free_space_map_->FindPage(space_needed)) != INVALID_PAGE_ID) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (!guard.IsValid()) {
+      break;
+    }
+    auto *page = guard.As<TablePage>();
+    const bool is_inserted = page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+    free_space_map_->UpdatePage(page_id, page->GetFreeSpaceRemaining());
+    if (is_inserted) {
+      guard.MarkDirty();
+      guard.Drop();
+      // Update the transaction's write set.
+      txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+      return true;
+    }
+  }
+
+  // No page has enough space, so the tuple goes to a new page at the end of the table.
+  if (!AppendPage(tuple, rid, txn, &tail)) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-
-  cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
-    } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-        txn->SetState(TransactionState::ABORTED);
-        return false;
-      }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
-    }
-  }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
+auto TableHeap::AppendPage(const Tuple &tuple, RID *rid, Transaction *txn, Tail *tail) -> bool {
+  page_id_t new_page_id;
+  WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id, &extent_);
+  // If we could not create a new page, then life sucks and we abort the transaction.
+  if (!new_guard.IsValid()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(append_latch_);
+  {
+    WritePageGuard last_guard = buffer_pool_manager_->FetchPageWrite(last_page_id_);
+    if (!last_guard.IsValid()) {
+      new_guard.Drop();
+      buffer_pool_manager_->DeletePage(new_page_id);
+      return false;
+    }
+    last_guard.AsMut<TablePage>()->SetNextPageId(new_page_id);
+  }
+  auto *new_page = new_guard.AsMut<TablePage>();
+  new_page->Init(new_page_id, PAGE_SIZE, last_page_id_, log_manager_, txn);
+  last_page_id_ = new_page_id;
+  const bool is_inserted = new_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+  page_id_t expected = INVALID_PAGE_ID;
+  if (tail->page_id_.compare_exchange_strong(expected, new_page_id)) {
+    // The page is recorded as full while its tail fills it, so other threads' inserts do not come to it.
+    free_space_map_->AddPage(new_page_id, 0);
+  } else {
+    // Another thread of the tail appended a page first. This one is left to whichever insert finds it.
+    free_space_map_->AddPage(new_page_id, new_page->GetFreeSpaceRemaining());
+  }
+  return is_inserted;
+}
+
+auto TableHeap::BulkInsertTuple(const Tuple &tuple, BulkLoad *load, Transaction *txn, std::vector<RID> *rids)
+    -> bool {
+  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+    return false;
+  }
+  RID rid;
+  if (!load->guard_.IsValid() || !load->guard_.AsMut<TablePage>()->BulkInsertTuple(tuple, &rid)) {
+    // The current page is full; start a new one.
+    page_id_t new_page_id;
+    WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id, &extent_);
+    if (!new_guard.IsValid()) {
+      return false;
+    }
+    // Until the load is finished, the new page is only linked to the other pages loaded.
+    auto *new_page = new_guard.AsMut<TablePage>();
+    const page_id_t prev_page_id = load->page_ids_.empty() ? INVALID_PAGE_ID : load->page_ids_.back();
+    new_page->Init(new_page_id, PAGE_SIZE, prev_page_id, log_manager_, txn);
+    if (load->guard_.IsValid()) {
+      load->guard_.AsMut<TablePage>()->SetNextPageId(new_page_id);
+      load->guard_.Drop();
+      // Full pages are written out right away, in the order they were loaded.
+      buffer_pool_manager_->FlushPage(prev_page_id);
+    }
+    load->page_ids_.push_back(new_page_id);
+    load->guard_ = std::move(new_guard);
+    if (!new_page->BulkInsertTuple(tuple, &rid)) {
+      return false;
+    }
+  }
+  if (rids != nullptr) {
+    rids->push_back(rid);
+  }
+  return true;
+}
+
+auto TableHeap::FinishBulkInsert(BulkLoad *load, Transaction *txn) -> bool {
+  if (load->page_ids_.empty()) {
+    return true;
+  }
+  load->guard_.Drop();
+  const page_id_t first_page_id = load->page_ids_.front();
+  const page_id_t last_page_id = load->page_ids_.back();
+  {
+    std::unique_lock<std::mutex> lock(append_latch_);
+    WritePageGuard last_guard = buffer_pool_manager_->FetchPageWrite(last_page_id_);
+    WritePageGuard first_guard = buffer_pool_manager_->FetchPageWrite(first_page_id);
+    if (!last_guard.IsValid() || !first_guard.IsValid()) {
+      last_guard.Drop();
+      first_guard.Drop();
+      lock.unlock();
+      AbandonBulkInsert(load);
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    // Link all loaded pages to the end of the list at once.
+    first_guard.AsMut<TablePage>()->SetPrevPageId(last_page_id_);
+    last_guard.AsMut<TablePage>()->SetNextPageId(first_page_id);
+    last_page_id_ = last_page_id;
+    // The pages are recorded as full until the bulk insert commits, so a rollback only removes its own tuples.
+    for (const page_id_t page_id : load->page_ids_) {
+      free_space_map_->AddPage(page_id, 0);
+    }
+  }
+  // The first page has a new prev page id, and the last one has not been written out yet.
+  buffer_pool_manager_->FlushPage(first_page_id);
+  buffer_pool_manager_->FlushPage(last_page_id);
+  // Update the transaction's write set.
+  txn->GetWriteSet()->emplace_back(RID(last_page_id, load->page_ids_.size()), WType::BULK_INSERT, Tuple{}, this);
+  return true;
+}
+
+void TableHeap::AbandonBulkInsert(BulkLoad *load) {
+  load->guard_.Drop();
+  for (const page_id_t page_id : load->page_ids_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  load->page_ids_.clear();
+}
+
 auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
-  // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.AsMut<TablePage>()->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
@@ -111,18 +269,20 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
 
 auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
-  page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  bool is_updated = guard.As<TablePage>()->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  if (is_updated) {
+    guard.MarkDirty();
+    free_space_map_->UpdatePage(rid.GetPageId(), guard.As<TablePage>()->GetFreeSpaceRemaining());
+  }
+  guard.Drop();
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -132,63 +292,224 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
-  page->WLatch();
+  auto *page = guard.AsMut<TablePage>();
   page->ApplyDelete(rid, txn, log_manager_);
+  // The space the tuple took can be used by inserts again.
+  free_space_map_->UpdatePage(rid.GetPageId(), page->GetFreeSpaceRemaining());
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
   // Rollback the delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.AsMut<TablePage>()->RollbackDelete(rid, txn, log_manager_);
+}
+
+void TableHeap::CommitBulkInsert(const RID &rid, Transaction *txn) {
+  // Only the last page loaded has more than a sliver of space left.
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find the last page of a bulk insert.");
+  free_space_map_->UpdatePage(rid.GetPageId(), guard.As<TablePage>()->GetFreeSpaceRemaining());
+}
+
+void TableHeap::RollbackBulkInsert(const RID &rid, Transaction *txn) {
+  // Walk back from the last page loaded, emptying as many pages as were loaded.
+  page_id_t page_id = rid.GetPageId();
+  for (uint32_t i = 0; i < rid.GetSlotNum(); i++) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page of a bulk insert.");
+    auto *page = guard.AsMut<TablePage>();
+    page->Clear();
+    free_space_map_->UpdatePage(page_id, page->GetFreeSpaceRemaining());
+    page_id = page->GetPrevPageId();
+  }
 }
 
 auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Read the tuple from the page.
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return guard.As<TablePage>()->GetTuple(rid, tuple, txn, lock_manager_);
 }
 
-auto TableHeap::Begin(Transaction *txn) -> TableIterator {
+auto TableHeap::Begin(Transaction *txn, BufferAccessStrategy *strategy) -> TableIterator {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
+  // Vacuum() removes empty pages, but only eventually. Until the iterator exists, the walk counts as one.
+  active_iterators_++;
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    page->RLatch();
-    // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-    auto found_tuple = page->GetFirstTupleRid(&rid);
-    page->RUnlatch();
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
+    bool found_tuple;
+    page_id_t next_page_id;
+    uint64_t version;
+    do {
+      version = page->BeginOptimisticRead();
+      // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
+      found_tuple = page->GetFirstTupleRid(&rid);
+      next_page_id = page->GetNextPageId();
+    } while (!page->ValidateOptimisticRead(version));
     buffer_pool_manager_->UnpinPage(page_id, false);
     if (found_tuple) {
       break;
     }
-    page_id = page->GetNextPageId();
+    page_id = next_page_id;
   }
-  return TableIterator(this, rid, txn);
+  TableIterator begin(this, rid, txn, strategy);
+  active_iterators_--;
+  return begin;
 }
 
 auto TableHeap::End() -> TableIterator { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
 
+auto TableHeap::Vacuum(size_t max_pages) -> VacuumStats {
+  std::lock_guard<std::mutex> lock(vacuum_latch_);
+  VacuumStats stats;
+  if (vacuum_page_id_ == INVALID_PAGE_ID) {
+    vacuum_page_id_ = first_page_id_;
+  }
+  while (stats.pages_scanned_ < max_pages && !stats.finished_pass_) {
+    const page_id_t page_id = vacuum_page_id_;
+    page_id_t prev_page_id;
+    page_id_t next_page_id;
+    bool is_empty;
+    {
+      WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+      if (!guard.IsValid()) {
+        break;
+      }
+      auto *page = guard.As<TablePage>();
+      if (page->Compact()) {
+        guard.MarkDirty();
+        stats.pages_compacted_++;
+        // A tail page stays recorded as full until its tail moves on.
+        if (!IsTailPage(page_id)) {
+          free_space_map_->UpdatePage(page_id, page->GetFreeSpaceRemaining());
+        }
+      }
+      prev_page_id = page->GetPrevPageId();
+      next_page_id = page->GetNextPageId();
+      is_empty = page->IsEmpty();
+    }
+    stats.pages_scanned_++;
+    // The first and last pages stay, so the list never has to be entered or appended to anywhere else.
+    if (is_empty && page_id != first_page_id_ && next_page_id != INVALID_PAGE_ID &&
+        UnlinkPage(prev_page_id, page_id, next_page_id)) {
+      stats.pages_unlinked_++;
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      stats.finished_pass_ = true;
+      vacuum_page_id_ = INVALID_PAGE_ID;
+    } else {
+      vacuum_page_id_ = next_page_id;
+    }
+  }
+  stats.pages_freed_ = FreeRetiredPages();
+  return stats;
+}
+
+auto TableHeap::IsTailPage(page_id_t page_id) -> bool {
+  return std::any_of(tails_.begin(), tails_.end(), [page_id](const Tail &tail) { return tail.page_id_ == page_id; });
+}
+
+auto TableHeap::UnlinkPage(page_id_t prev_page_id, page_id_t page_id, page_id_t next_page_id) -> bool {
+  {
+    // Latch the pages in list order, as appends do.
+    WritePageGuard prev_guard = buffer_pool_manager_->FetchPageWrite(prev_page_id);
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+    WritePageGuard next_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+    if (!prev_guard.IsValid() || !guard.IsValid() || !next_guard.IsValid()) {
+      return false;
+    }
+    auto *prev_page = prev_guard.As<TablePage>();
+    auto *page = guard.As<TablePage>();
+    auto *next_page = next_guard.As<TablePage>();
+    // An insert may have come to the page since it was found empty.
+    if (prev_page->GetNextPageId() != page_id || page->GetPrevPageId() != prev_page_id ||
+        page->GetNextPageId() != next_page_id || next_page->GetPrevPageId() != page_id || !page->IsEmpty() ||
+        IsTailPage(page_id)) {
+      return false;
+    }
+    prev_guard.AsMut<TablePage>()->SetNextPageId(next_page_id);
+    next_guard.AsMut<TablePage>()->SetPrevPageId(prev_page_id);
+    // Inserts that found the page before it was unlinked fail on it and look elsewhere.
+    guard.AsMut<TablePage>()->Seal();
+    free_space_map_->RemovePage(page_id);
+  }
+  // The new links are written back before the page is deleted, so the list on disk never leads to a freed page.
+  buffer_pool_manager_->FlushPage(prev_page_id);
+  buffer_pool_manager_->FlushPage(next_page_id);
+  retired_page_ids_.push_back(page_id);
+  return true;
+}
+
+auto TableHeap::FreeRetiredPages() -> size_t {
+  if (retired_page_ids_.empty()) {
+    return 0;
+  }
+  // An insert that got one of the pages from its tail or the free-space map holds its tail's latch until it is done.
+  for (Tail &tail : tails_) {
+    std::unique_lock<std::shared_mutex> tail_lock(tail.latch_);
+  }
+  // A scan may be on one of the pages, or about to move onto one. Scans that start from now on cannot reach them.
+  if (active_iterators_ > 0) {
+    return 0;
+  }
+  const size_t num_retired = retired_page_ids_.size();
+  retired_page_ids_.erase(std::remove_if(retired_page_ids_.begin(), retired_page_ids_.end(),
+                                         [this](page_id_t page_id) {
+                                           // A page the cleaner or a prefetch has pinned is tried again next time.
+                                           return buffer_pool_manager_->DeletePage(page_id);
+                                         }),
+                          retired_page_ids_.end());
+  return num_retired - retired_page_ids_.size();
+}
+
+void TableHeap::StartVacuum(std::chrono::milliseconds interval, size_t pages_per_round) {
+  std::lock_guard<std::mutex> lock(vacuum_thread_latch_);
+  if (vacuum_thread_.joinable()) {
+    return;
+  }
+  vacuum_interval_ = interval;
+  vacuum_pages_per_round_ = pages_per_round;
+  stop_vacuum_ = false;
+  vacuum_thread_ = std::thread(&TableHeap::RunVacuum, this);
+}
+
+void TableHeap::StopVacuum() {
+  {
+    std::lock_guard<std::mutex> lock(vacuum_thread_latch_);
+    if (!vacuum_thread_.joinable()) {
+      return;
+    }
+    stop_vacuum_ = true;
+  }
+  vacuum_cv_.notify_one();
+  vacuum_thread_.join();
+}
+
+void TableHeap::RunVacuum() {
+  std::unique_lock<std::mutex> lock(vacuum_thread_latch_);
+  while (!stop_vacuum_) {
+    vacuum_cv_.wait_for(lock, vacuum_interval_);
+    if (stop_vacuum_) {
+      break;
+    }
+    lock.unlock();
+    Vacuum(vacuum_pages_per_round_);
+    lock.lock();
+  }
+}
+
 }  // namespace bustub
@@ -10,15 +10,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+namespace {
+/** Follows the table heap's page chain for read-ahead. */
+auto NextTablePageId(Page *page) -> page_id_t { return reinterpret_cast<TablePage *>(page)->GetNextPageId(); }
+}  // namespace
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
+    EnterTable();
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
 }
@@ -35,35 +42,70 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_));
   assert(cur_page != nullptr);  // all pages are pinned
 
+  // Finding the next slot only reads the slot array and the page chain, so it validates against concurrent writers
+  // instead of taking the read latch; GetTuple() latches the page to copy the tuple.
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
-        break;
-      }
+  bool first_page = true;
+  while (true) {
+    const uint64_t version = cur_page->BeginOptimisticRead();
+    const bool found = first_page ? cur_page->GetNextTupleRid(tuple_->rid_, &next_tuple_rid)
+                                  : cur_page->GetFirstTupleRid(&next_tuple_rid);
+    const page_id_t next_page_id = cur_page->GetNextPageId();
+    if (!cur_page->ValidateOptimisticRead(version)) {
+      continue;
+    }
+    if (!first_page) {
+      ReadAhead(next_page_id);
+    }
+    if (found || next_page_id == INVALID_PAGE_ID) {
+      break;
     }
+    auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(next_page_id, strategy_));
+    buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+    cur_page = next_page;
+    first_page = false;
   }
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+  } else {
+    LeaveTable();
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
   buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
+void TableIterator::ReadAhead(page_id_t next_page_id) {
+  if (pages_until_readahead_ > 0) {
+    pages_until_readahead_--;
+    return;
+  }
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  // Pages prefetched through the scan ring must not recycle each other before the scan gets to them.
+  const size_t max_window =
+      strategy_ == nullptr ? READAHEAD_MAX_PAGES : std::min(READAHEAD_MAX_PAGES, strategy_->GetRingSize() / 2);
+  readahead_window_ = std::min(readahead_window_ == 0 ? READAHEAD_MIN_PAGES : readahead_window_ * 2, max_window);
+  if (readahead_window_ == 0) {
+    return;
+  }
+  PrefetchChain chain;
+  chain.length_ = readahead_window_;
+  chain.next_page_ = &NextTablePageId;
+  chain.strategy_ = strategy_;
+  table_heap_->buffer_pool_manager_->PrefetchPage(next_page_id, chain);
+  pages_until_readahead_ = readahead_window_ / 2;
+}
+
+void TableIterator::EnterTable() const { table_heap_->active_iterators_++; }
+
+void TableIterator::LeaveTable() const { table_heap_->active_iterators_--; }
+
 auto TableIterator::operator++(int) -> TableIterator {
   TableIterator clone(*this);
   ++(*this);
@@ -11,9 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <iostream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -80,6 +86,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
 
   delete bpm;
   delete disk_manager;
@@ -136,9 +143,616 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
 
   delete bpm;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CleanerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t clean_reserve = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, clean_reserve);
+
+  // Scenario: fill the pool with dirty pages and unpin them, oldest first.
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    pages.push_back(bpm->NewPage(&page_id_temp));
+    ASSERT_NE(nullptr, pages.back());
+    snprintf(pages.back()->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: the cleaner writes back the next clean_reserve victims in the background.
+  auto all_clean = [&] {
+    for (size_t i = 0; i < clean_reserve; ++i) {
+      if (pages[i]->IsDirty()) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int wait = 0; wait < 100 && !all_clean(); ++wait) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(all_clean());
+
+  // Scenario: evicting the cleaned pages and reading them back returns the written data.
+  for (size_t i = 0; i < clean_reserve; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  for (size_t i = 0; i < clean_reserve; ++i) {
+    char expected[PAGE_SIZE];
+    snprintf(expected, PAGE_SIZE, "page %zu", i);
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ScanRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t hot_pages = 5;
+  const size_t scan_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a table bigger than the pool is written out, then a few hot pages are created and left dirty.
+  std::vector<page_id_t> scan_page_ids(scan_pages);
+  for (size_t i = 0; i < scan_pages; ++i) {
+    Page *page = bpm->NewPage(&scan_page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "scan %d", scan_page_ids[i]);
+    EXPECT_EQ(true, bpm->UnpinPage(scan_page_ids[i], true));
+  }
+  bpm->FlushAllPages();
+  std::vector<page_id_t> hot_page_ids(hot_pages);
+  for (size_t i = 0; i < hot_pages; ++i) {
+    Page *page = bpm->NewPage(&hot_page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hot %d", hot_page_ids[i]);
+    EXPECT_EQ(true, bpm->UnpinPage(hot_page_ids[i], true));
+  }
+
+  // Scenario: a scan through a two-frame ring reads every page correctly.
+  BufferAccessStrategy strategy(2);
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < scan_pages; ++i) {
+    Page *page = bpm->FetchPage(scan_page_ids[i], &strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "scan %d", scan_page_ids[i]);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(scan_page_ids[i], false));
+  }
+
+  // The hot pages were never evicted: their contents were never written to disk, yet they are still readable.
+  char disk_data[PAGE_SIZE];
+  for (size_t i = 0; i < hot_pages; ++i) {
+    disk_manager->ReadPage(hot_page_ids[i], disk_data);
+    snprintf(expected, PAGE_SIZE, "hot %d", hot_page_ids[i]);
+    EXPECT_NE(0, strcmp(disk_data, expected));
+    Page *page = bpm->FetchPage(hot_page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(hot_page_ids[i], false));
+  }
+
+  // Scenario: a pinned ring page is skipped, and the scan takes a frame from the rest of the pool instead.
+  BufferAccessStrategy pinned_strategy(1);
+  ASSERT_NE(nullptr, bpm->FetchPage(scan_page_ids[0], &pinned_strategy));
+  ASSERT_NE(nullptr, bpm->FetchPage(scan_page_ids[1], &pinned_strategy));
+  EXPECT_EQ(true, bpm->UnpinPage(scan_page_ids[1], false));
+  EXPECT_EQ(true, bpm->UnpinPage(scan_page_ids[0], false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t chain_length = 6;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a chain of pages that store the id of the next page up front is written out and evicted.
+  std::vector<page_id_t> chain_page_ids(chain_length);
+  std::vector<Page *> chain_pages(chain_length);
+  for (size_t i = 0; i < chain_length; ++i) {
+    chain_pages[i] = bpm->NewPage(&chain_page_ids[i]);
+    ASSERT_NE(nullptr, chain_pages[i]);
+  }
+  for (size_t i = 0; i < chain_length; ++i) {
+    const page_id_t next_page_id = i + 1 < chain_length ? chain_page_ids[i + 1] : INVALID_PAGE_ID;
+    memcpy(chain_pages[i]->GetData(), &next_page_id, sizeof(page_id_t));
+    snprintf(chain_pages[i]->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "chain %zu", i);
+    EXPECT_EQ(true, bpm->UnpinPage(chain_page_ids[i], true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: prefetch the whole chain from its first page. Destroying the strategy waits for the prefetcher.
+  {
+    BufferAccessStrategy strategy(chain_length);
+    PrefetchChain chain;
+    chain.length_ = chain_length;
+    chain.next_page_ = [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); };
+    chain.strategy_ = &strategy;
+    bpm->PrefetchPage(chain_page_ids[0], chain);
+  }
+
+  // The chain is resident: clobbering the pages on disk does not change what FetchPage returns.
+  char zeros[PAGE_SIZE] = {0};
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < chain_length; ++i) {
+    disk_manager->WritePage(chain_page_ids[i], zeros);
+  }
+  for (size_t i = 0; i < chain_length; ++i) {
+    Page *page = bpm->FetchPage(chain_page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "chain %zu", i);
+    EXPECT_EQ(0, strcmp(page->GetData() + sizeof(page_id_t), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(chain_page_ids[i], false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures creating and deleting pages, which takes frames from the free list and hands them back, and fetching
+// resident pages through a full replacer.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_FrameListBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 1024;
+  const int num_ops = 200000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids(buffer_pool_size / 2);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i += page_ids.size()) {
+    for (auto &page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    for (const page_id_t page_id : page_ids) {
+      ASSERT_TRUE(bpm->DeletePage(page_id));
+    }
+  }
+  auto new_delete_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  std::mt19937 engine(15445);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    const page_id_t page_id = page_ids[engine() % page_ids.size()];
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto fetch_unpin_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "NewPage+UnpinPage+DeletePage: " << new_delete_ns / num_ops << " ns/op" << std::endl;
+  std::cout << "FetchPage+UnpinPage (hit): " << fetch_unpin_ns / num_ops << " ns/op" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ClockReplacerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const page_id_t num_pages = 64;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, 0, ReplacerType::CLOCK);
+
+  // Scenario: with every frame pinned there is no victim; an unpinned page becomes one.
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[3], true));
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  for (const page_id_t id : page_ids) {
+    bpm->UnpinPage(id, true);
+  }
+  while (true) {
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    if (page_id == num_pages - 1) {
+      break;
+    }
+    page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+  }
+
+  // Scenario: concurrent hits and misses keep every page's content.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 engine(tid);
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 20000; i++) {
+        const auto id = static_cast<page_id_t>(buffer_pool_size + engine() % (num_pages - buffer_pool_size));
+        Page *page = bpm->FetchPage(id);
+        if (page == nullptr) {
+          continue;
+        }
+        snprintf(expected, PAGE_SIZE, "page %d", id);
+        page->RLatch();
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        page->RUnlatch();
+        EXPECT_TRUE(bpm->UnpinPage(id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AvailableFramesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, 0, replacer_type);
+    EXPECT_EQ(buffer_pool_size, bpm->GetAvailableFrames());
+
+    // Scenario: every pinned page takes a frame away, unpinning gives it back.
+    std::vector<page_id_t> page_ids(buffer_pool_size);
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+      EXPECT_EQ(buffer_pool_size - i - 1, bpm->GetAvailableFrames());
+    }
+    page_id_t page_id;
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[0], true));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[1], false));
+    EXPECT_EQ(2, bpm->GetAvailableFrames());
+
+    // Scenario: a second pin on a page and a failed unpin leave the count alone; evicting a dirty page does too.
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[2]));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[2], false));
+    EXPECT_FALSE(bpm->UnpinPage(page_ids[0], false));
+    EXPECT_EQ(2, bpm->GetAvailableFrames());
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(1, bpm->GetAvailableFrames());
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+    EXPECT_EQ(2, bpm->GetAvailableFrames());
+
+    // Scenario: re-fetching an unpinned page and flushing everything keep the count exact.
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+    EXPECT_EQ(1, bpm->GetAvailableFrames());
+    bpm->FlushAllPages();
+    EXPECT_EQ(1, bpm->GetAvailableFrames());
+    for (size_t i = 1; i < buffer_pool_size; i++) {
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    EXPECT_EQ(buffer_pool_size, bpm->GetAvailableFrames());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// FlushAllPages() on a clean pool only sweeps the book-keeping of every frame. Page objects are packed apart from the
+// page data, so the sweep reads a few cache lines per dozens of frames instead of touching one line per 4 KB.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_FrameSweepBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8192;
+  const int num_sweeps = 200;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    // Frames can be read and written with O_DIRECT in place.
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  bpm->FlushAllPages();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_sweeps; i++) {
+    bpm->FlushAllPages();
+  }
+  auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "FlushAllPages (clean, " << buffer_pool_size << " frames): " << ns / num_sweeps / buffer_pool_size
+            << " ns/frame" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Several threads fetch resident pages. With CLOCK a hit only touches the frame's pin count and reference bit; with
+// LRU every hit goes through the replacer's latch twice.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_ReplacerHitBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 256;
+  const int num_threads = 4;
+  const int num_ops = 200000;
+
+  for (const auto &[replacer_type, name] : {std::make_pair(ReplacerType::LRU, "LRU"),
+                                           std::make_pair(ReplacerType::LRU_K, "LRU-K"),
+                                           std::make_pair(ReplacerType::CLOCK, "CLOCK")}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, 0, replacer_type);
+    std::vector<page_id_t> page_ids(buffer_pool_size);
+    for (auto &page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&, tid] {
+        std::mt19937 engine(tid);
+        for (int i = 0; i < num_ops; i++) {
+          const page_id_t page_id = page_ids[engine() % buffer_pool_size];
+          bpm->FetchPage(page_id);
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << " FetchPage+UnpinPage (hit, " << num_threads << " threads): " << ns / num_ops << " ns/op"
+              << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "test.db";
+
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::CLOCK}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(4, disk_manager, nullptr, 0, replacer_type, 2, 16);
+    EXPECT_EQ(4, bpm->GetPoolSize());
+    EXPECT_EQ(16, bpm->GetMaxPoolSize());
+    EXPECT_FALSE(bpm->Resize(17));
+    EXPECT_FALSE(bpm->Resize(0));
+
+    // Scenario: growing adds free frames, so more pages can be pinned at once.
+    std::vector<page_id_t> page_ids(16);
+    for (size_t i = 0; i < 4; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+    }
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_ids[4]));
+    ASSERT_TRUE(bpm->Resize(16));
+    EXPECT_EQ(16, bpm->GetPoolSize());
+    EXPECT_EQ(12, bpm->GetAvailableFrames());
+    for (size_t i = 4; i < 16; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+      snprintf(bpm->FetchPage(page_ids[i])->GetData(), PAGE_SIZE, "page %zu", i);
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+    }
+    for (size_t i = 0; i < 16; i++) {
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+    }
+
+    // Scenario: shrinking evicts the pages of the frames removed, writing back the dirty ones.
+    ASSERT_TRUE(bpm->Resize(6));
+    EXPECT_EQ(6, bpm->GetPoolSize());
+    EXPECT_EQ(6, bpm->GetAvailableFrames());
+    for (size_t i = 4; i < 16; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+
+    // Scenario: a page that stays pinned keeps its frame, and the pool shrinks only down to it.
+    std::vector<Page *> pinned;
+    for (size_t i = 0; i < 6; i++) {
+      pinned.push_back(bpm->FetchPage(page_ids[i]));
+      ASSERT_NE(nullptr, pinned.back());
+    }
+    const auto highest = std::max_element(pinned.begin(), pinned.end());
+    const size_t highest_frame = *highest - bpm->GetPages();
+    const page_id_t highest_page_id = (*highest)->GetPageId();
+    for (Page *page : pinned) {
+      if (page != *highest) {
+        ASSERT_TRUE(bpm->UnpinPage(page->GetPageId(), false));
+      }
+    }
+    EXPECT_FALSE(bpm->Resize(1));
+    EXPECT_EQ(highest_frame + 1, bpm->GetPoolSize());
+    ASSERT_TRUE(bpm->UnpinPage(highest_page_id, false));
+    ASSERT_TRUE(bpm->Resize(1));
+    EXPECT_EQ(1, bpm->GetAvailableFrames());
+    for (size_t i = 0; i < 16; i++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+      page_id_t page_id;
+      EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PinCountTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_threads = 4;
+  const int num_ops = 20000;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t hot_page_id;
+  Page *hot_page = bpm->NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, hot_page);
+  std::vector<page_id_t> cold_page_ids(4 * buffer_pool_size);
+  for (auto &page_id : cold_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a page stays pinned, like a hash table's directory page, while threads pin and unpin it again and
+  // another thread keeps evicting and loading the other frames. Every pin is accounted for at the end.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_ops; i++) {
+        ASSERT_EQ(hot_page, bpm->FetchPage(hot_page_id));
+        ASSERT_TRUE(bpm->UnpinPage(hot_page_id, false));
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    for (int i = 0; i < num_ops; i++) {
+      const page_id_t page_id = cold_page_ids[i % cold_page_ids.size()];
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, hot_page->GetPinCount());
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    Page *page = &bpm->GetPages()[i];
+    EXPECT_EQ(page == hot_page ? 1 : 0, page->GetPinCount());
+  }
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetAvailableFrames());
+
+  // Scenario: a page cannot be pinned more than MAX_PIN_COUNT times, so its pin count never overflows.
+  for (int i = 1; i < BufferPoolManagerInstance::MAX_PIN_COUNT; i++) {
+    ASSERT_EQ(hot_page, bpm->FetchPage(hot_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(hot_page_id));
+  EXPECT_EQ(BufferPoolManagerInstance::MAX_PIN_COUNT, hot_page->GetPinCount());
+  for (int i = 0; i < BufferPoolManagerInstance::MAX_PIN_COUNT; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(hot_page_id, false));
+  }
+  EXPECT_FALSE(bpm->UnpinPage(hot_page_id, false));
+  EXPECT_EQ(0, hot_page->GetPinCount());
+  EXPECT_EQ(buffer_pool_size, bpm->GetAvailableFrames());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Several threads pin and unpin a page that stays pinned, the access pattern of a hash table's directory page. Each
+// pin and unpin is a single atomic instruction on the frame's pin count, so the threads only share its cache line.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_PinnedPageBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const int num_ops = 500000;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+
+  for (const int num_threads : {1, 4}) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < num_ops; i++) {
+          bpm->FetchPage(page_id);
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "FetchPage+UnpinPage (pinned page, " << num_threads << " threads): " << ns / num_ops / num_threads
+              << " ns/op" << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
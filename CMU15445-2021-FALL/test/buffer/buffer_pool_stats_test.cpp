@@ -0,0 +1,219 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats_test.cpp
+//
+// Identification: test/buffer/buffer_pool_stats_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, HistogramTest) {
+  // Scenario: small values get a bucket each, larger ones share buckets that cover 1/8 of their power of two.
+  for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKETS; value++) {
+    EXPECT_EQ(value, LatencyHistogram::BucketOf(value));
+  }
+  for (const uint64_t value : {8UL, 9UL, 15UL, 16UL, 17UL, 100UL, 1000UL, 123456789UL}) {
+    const size_t bucket = LatencyHistogram::BucketOf(value);
+    EXPECT_LE(LatencyHistogram::BucketLowerBound(bucket), value);
+    EXPECT_GE(LatencyHistogram::BucketUpperBound(bucket), value);
+    EXPECT_LE(LatencyHistogram::BucketUpperBound(bucket) - LatencyHistogram::BucketLowerBound(bucket), value / 8);
+  }
+  EXPECT_EQ(LatencyHistogram::BucketOf(16), LatencyHistogram::BucketOf(17));
+  EXPECT_NE(LatencyHistogram::BucketOf(17), LatencyHistogram::BucketOf(18));
+  EXPECT_EQ(LatencyHistogram::NUM_BUCKETS - 1, LatencyHistogram::BucketOf(UINT64_MAX));
+  for (size_t bucket = 0; bucket + 1 < LatencyHistogram::NUM_BUCKETS; bucket++) {
+    ASSERT_EQ(LatencyHistogram::BucketUpperBound(bucket) + 1, LatencyHistogram::BucketLowerBound(bucket + 1));
+  }
+
+  // Scenario: percentiles are read off the buckets, to within a bucket of the exact value.
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.Percentile(0.5));
+  for (uint64_t value = 1; value <= 1000; value++) {
+    histogram.Record(value);
+  }
+  EXPECT_EQ(1000, histogram.Count());
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketOf(500)), histogram.Percentile(0.5));
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketOf(990)), histogram.Percentile(0.99));
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketOf(1000)), histogram.Percentile(1));
+  EXPECT_EQ(1, histogram.Percentile(0));
+
+  LatencyHistogram other;
+  other.Record(1000000);
+  histogram.Merge(other);
+  EXPECT_EQ(1001, histogram.Count());
+  EXPECT_LE(1000000, histogram.Percentile(1));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, CounterTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(2, disk_manager);
+
+  // Scenario: new pages come from the free list and count neither as fetches nor as evictions.
+  page_id_t page_id0;
+  page_id_t page_id1;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id0));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id0, true));
+  ASSERT_TRUE(bpm->UnpinPage(page_id1, true));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(0, stats.hits_ + stats.misses_ + stats.evictions_ + stats.pin_failures_);
+
+  // Scenario: a resident page is a hit; a new page evicts the dirty unpinned page, writing it back first.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  page_id_t page_id2;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id2));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_write_stalls_);
+  EXPECT_EQ(1, stats.dirty_writebacks_);
+
+  // Scenario: with every frame pinned, fetching and creating pages fail.
+  page_id_t page_id3;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id3));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_id1));
+  EXPECT_EQ(2, bpm->GetStats().pin_failures_);
+
+  // Scenario: fetching the evicted page again is a miss that evicts another dirty page.
+  ASSERT_TRUE(bpm->UnpinPage(page_id0, false));
+  ASSERT_TRUE(bpm->UnpinPage(page_id2, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id1, false));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.dirty_writebacks_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+
+  // Scenario: flushing writes back the remaining dirty page once; flushing it again writes a clean page.
+  bpm->FlushAllPages();
+  bpm->FlushAllPages();
+  EXPECT_EQ(3, bpm->GetStats().dirty_writebacks_);
+
+  const std::string json = bpm->GetStats().ToJson();
+  EXPECT_EQ('{', json.front());
+  EXPECT_EQ('}', json.back());
+  EXPECT_NE(std::string::npos, json.find("\"hits\":1,\"misses\":1,\"hit_ratio\":0.5,\"compressed_hits\":0"));
+  EXPECT_NE(std::string::npos, json.find("\"evictions\":2"));
+  EXPECT_NE(std::string::npos, json.find("\"pin_failures\":2"));
+  EXPECT_NE(std::string::npos, json.find("\"fetch_latency_ns\":{\"samples\":"));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, ParallelTest) {
+  const std::string db_name = "test.db";
+  const int num_threads = 4;
+  const int num_fetches = 10000;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 8, disk_manager);
+
+  std::vector<page_id_t> page_ids(4);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: hits counted by many threads on several instances add up to the number of fetches.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int i = 0; i < num_fetches; i++) {
+        const page_id_t page_id = page_ids[(tid + i) % page_ids.size()];
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(num_threads * num_fetches, stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+  // Every thread times one in LATENCY_SAMPLE_PERIOD of its fetches.
+  EXPECT_LE(num_threads * (num_fetches / BufferPoolStatsRecorder::LATENCY_SAMPLE_PERIOD - 1),
+            stats.fetch_latency_.Count());
+  EXPECT_GE(num_threads * (num_fetches / BufferPoolStatsRecorder::LATENCY_SAMPLE_PERIOD + 1),
+            stats.fetch_latency_.Count());
+  EXPECT_LE(stats.fetch_latency_.Percentile(0.5), stats.fetch_latency_.Percentile(0.99));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures what the counters cost on the cheapest path they are on: fetching a resident page.
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, DISABLED_BenchmarkTest) {
+  const std::string db_name = "test.db";
+  const int num_ops = 1000000;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    bpm->FetchPage(page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+  const auto fetch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  BufferPoolStatsRecorder recorder;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    BufferPoolStatsRecorder::FetchTimer timer(&recorder);
+    recorder.Add(BufferPoolCounter::HITS);
+  }
+  const auto stats_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_ops, recorder.Snapshot().hits_);
+
+  start = std::chrono::steady_clock::now();
+  const BufferPoolStats stats = bpm->GetStats();
+  const auto snapshot_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_ops, stats.hits_);
+
+  std::cout << "FetchPage+UnpinPage (hit): " << fetch_ns / num_ops << " ns/op, of which counting and sampling: "
+            << stats_ns / num_ops << " ns/op" << std::endl;
+  std::cout << "GetStats: " << snapshot_ns << " ns, " << stats.ToJson() << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstdio>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -19,7 +21,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +61,52 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_frames = 64;
+  const int num_threads = 4;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: threads pin and unpin frames while another one takes victims; the bits never get out of step.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 engine(tid);
+      for (int i = 0; i < 100000; i++) {
+        const auto frame_id = static_cast<frame_id_t>(engine() % num_frames);
+        clock_replacer.Pin(frame_id);
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    for (int i = 0; i < 100000; i++) {
+      frame_id_t frame_id;
+      if (clock_replacer.Victim(&frame_id)) {
+        EXPECT_LT(static_cast<size_t>(frame_id), num_frames);
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(clock_replacer.Size(), num_frames);
+
+  // Scenario: once every frame is unpinned, each is victimized exactly once.
+  for (size_t i = 0; i < num_frames; i++) {
+    clock_replacer.Unpin(static_cast<frame_id_t>(i));
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+  std::vector<frame_id_t> victims;
+  frame_id_t frame_id;
+  while (clock_replacer.Victim(&frame_id)) {
+    victims.push_back(frame_id);
+  }
+  std::sort(victims.begin(), victims.end());
+  ASSERT_EQ(num_frames, victims.size());
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_EQ(static_cast<frame_id_t>(i), victims[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
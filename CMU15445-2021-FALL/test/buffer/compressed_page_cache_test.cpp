@@ -0,0 +1,261 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/page_compressor.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+/** Fill a page like a table page: a slot array at the front, records at the back and zeroed free space between. */
+void FillTablePage(char *data, int seed) {
+  memset(data, 0, PAGE_SIZE);
+  std::mt19937 engine(seed);
+  const int num_records = 40;
+  for (int i = 0; i < num_records; i++) {
+    char record[48] = {};
+    snprintf(record, sizeof(record), "customer#%06u|%08u|BUILDING|", static_cast<unsigned>(engine() % 100000),
+             static_cast<unsigned>(engine()));
+    const size_t offset = PAGE_SIZE - (i + 1) * sizeof(record);
+    memcpy(data + offset, record, sizeof(record));
+    const uint32_t slot[2] = {static_cast<uint32_t>(offset), static_cast<uint32_t>(sizeof(record))};
+    memcpy(data + 24 + i * sizeof(slot), slot, sizeof(slot));
+  }
+}
+
+/** @return true if data survives compressing and decompressing */
+auto RoundTrip(const std::vector<char> &data, size_t *compressed_size = nullptr) -> bool {
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  const size_t size = PageCompressor::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  if (compressed_size != nullptr) {
+    *compressed_size = size;
+  }
+  std::vector<char> decompressed(data.size());
+  return size != 0 && PageCompressor::Decompress(compressed.data(), size, decompressed.data(), data.size()) &&
+         decompressed == data;
+}
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, CompressorTest) {
+  // Scenario: every kind of input comes back unchanged, including sizes around the minimum match and long runs.
+  std::mt19937 engine(15445);
+  for (const int size : {0, 1, 3, 4, 5, 15, 16, 300, PAGE_SIZE}) {
+    std::vector<char> zeros(size, 0);
+    EXPECT_TRUE(RoundTrip(zeros)) << size;
+    std::vector<char> random(size);
+    for (auto &byte : random) {
+      byte = static_cast<char>(engine());
+    }
+    EXPECT_TRUE(RoundTrip(random)) << size;
+  }
+
+  // Scenario: zeroed and table-like pages shrink a lot; random bytes do not fit into less than a page.
+  std::vector<char> page(PAGE_SIZE, 0);
+  size_t compressed_size;
+  ASSERT_TRUE(RoundTrip(page, &compressed_size));
+  EXPECT_LT(compressed_size, 64);
+  FillTablePage(page.data(), 1);
+  ASSERT_TRUE(RoundTrip(page, &compressed_size));
+  EXPECT_LT(compressed_size, PAGE_SIZE / 2);
+  for (auto &byte : page) {
+    byte = static_cast<char>(engine());
+  }
+  std::vector<char> compressed(PAGE_SIZE);
+  EXPECT_EQ(0, PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE - 1));
+
+  // Scenario: malformed data is rejected instead of overrunning a buffer.
+  FillTablePage(page.data(), 2);
+  const size_t size = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+  ASSERT_NE(0, size);
+  std::vector<char> decompressed(PAGE_SIZE);
+  EXPECT_FALSE(PageCompressor::Decompress(compressed.data(), size / 2, decompressed.data(), PAGE_SIZE));
+  EXPECT_FALSE(PageCompressor::Decompress(compressed.data(), size, decompressed.data(), PAGE_SIZE - 1));
+  const char bad_offset[] = {0x10, 'a', 0x05, 0x00};
+  EXPECT_FALSE(PageCompressor::Decompress(bad_offset, sizeof(bad_offset), decompressed.data(), 5));
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, CacheTest) {
+  std::vector<char> page(PAGE_SIZE);
+  std::vector<char> out(PAGE_SIZE);
+  FillTablePage(page.data(), 0);
+  const size_t page_size = PageCompressor::Compress(page.data(), PAGE_SIZE, out.data(), PAGE_SIZE);
+  // Room for three pages, with some slack because the pages below differ in their first byte.
+  CompressedPageCache cache(3 * page_size + 32);
+
+  // Scenario: pages come back as they went in, and only once.
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    FillTablePage(page.data(), 0);
+    page[0] = static_cast<char>(page_id);
+    ASSERT_TRUE(cache.Insert(page_id, page.data()));
+  }
+  EXPECT_EQ(3, cache.Count());
+  ASSERT_TRUE(cache.Take(1, out.data()));
+  EXPECT_EQ(1, out[0]);
+  EXPECT_FALSE(cache.Take(1, out.data()));
+  EXPECT_EQ(2, cache.Count());
+
+  // Scenario: the oldest pages make room for new ones; a page inserted again replaces its old copy.
+  page[0] = 3;
+  ASSERT_TRUE(cache.Insert(3, page.data()));
+  page[0] = 4;
+  ASSERT_TRUE(cache.Insert(4, page.data()));
+  EXPECT_FALSE(cache.Take(0, out.data()));
+  page[0] = 5;
+  ASSERT_TRUE(cache.Insert(4, page.data()));
+  EXPECT_EQ(3, cache.Count());
+  EXPECT_LE(cache.Size(), 3 * page_size + 32);
+  ASSERT_TRUE(cache.Take(4, out.data()));
+  EXPECT_EQ(5, out[0]);
+  cache.Erase(3);
+  EXPECT_FALSE(cache.Take(3, out.data()));
+  ASSERT_TRUE(cache.Take(2, out.data()));
+  EXPECT_EQ(0, cache.Count());
+  EXPECT_EQ(0, cache.Size());
+
+  // Scenario: a page that does not compress well is not cached.
+  std::mt19937 engine(0);
+  for (auto &byte : page) {
+    byte = static_cast<char>(engine());
+  }
+  EXPECT_FALSE(cache.Insert(7, page.data()));
+  EXPECT_FALSE(cache.Take(7, out.data()));
+
+  // Scenario: a page compressed outside the cache gets in, unless it was taken or erased since it was reserved.
+  FillTablePage(page.data(), 0);
+  std::vector<char> compressed(CompressedPageCache::MAX_COMPRESSED_SIZE);
+  const size_t size = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+  uint64_t ticket = cache.Reserve(8);
+  ASSERT_TRUE(cache.Insert(8, ticket, compressed.data(), size));
+  ASSERT_TRUE(cache.Take(8, out.data()));
+  EXPECT_EQ(page, out);
+  ticket = cache.Reserve(8);
+  EXPECT_FALSE(cache.Take(8, out.data()));
+  EXPECT_FALSE(cache.Insert(8, ticket, compressed.data(), size));
+  ticket = cache.Reserve(8);
+  cache.Erase(8);
+  const uint64_t next_ticket = cache.Reserve(8);
+  EXPECT_FALSE(cache.Insert(8, ticket, compressed.data(), size));
+  ASSERT_TRUE(cache.Insert(8, next_ticket, compressed.data(), size));
+  EXPECT_EQ(1, cache.Count());
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 32;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager, nullptr, 0, ReplacerType::LRU, 2, 0, 64 * PAGE_SIZE);
+
+  std::vector<page_id_t> page_ids(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    FillTablePage(page->GetData(), i);
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+
+  // Scenario: pages evicted from the small pool are served from the compressed cache instead of the disk.
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      std::vector<char> expected(PAGE_SIZE);
+      FillTablePage(expected.data(), i + round * num_pages);
+      ASSERT_EQ(0, memcmp(expected.data(), page->GetData(), PAGE_SIZE)) << i;
+      // Change every page, so a stale copy in the cache would show in the next round.
+      FillTablePage(page->GetData(), i + (round + 1) * num_pages);
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+    }
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(2 * num_pages, stats.compressed_hits_);
+  EXPECT_EQ(0, stats.misses_);
+
+  // Scenario: a deleted page leaves the cache along with the pool.
+  ASSERT_TRUE(bpm->DeletePage(page_ids[0]));
+  Page *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, bpm->GetStats().misses_);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Measures the codec on table-like pages, and a buffer pool miss served by the compressed cache versus the disk.
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, DISABLED_BenchmarkTest) {
+  const int num_ops = 20000;
+  std::vector<char> page(PAGE_SIZE);
+  std::vector<char> compressed(PAGE_SIZE);
+  FillTablePage(page.data(), 0);
+  size_t size = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    size = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+  }
+  const auto compress_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    ASSERT_TRUE(PageCompressor::Decompress(compressed.data(), size, page.data(), PAGE_SIZE));
+  }
+  const auto decompress_ns =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Compress: " << compress_ns / num_ops << " ns/page, Decompress: " << decompress_ns / num_ops
+            << " ns/page, ratio " << static_cast<double>(PAGE_SIZE) / size << std::endl;
+
+  const std::string db_name = "test.db";
+  const int num_pages = 256;
+  for (const size_t cache_size : {size_t{0}, size_t{2 * num_pages * PAGE_SIZE}}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm =
+        new BufferPoolManagerInstance(16, disk_manager, nullptr, 0, ReplacerType::LRU, 2, 0, cache_size);
+    std::vector<page_id_t> page_ids(num_pages);
+    for (int i = 0; i < num_pages; i++) {
+      FillTablePage(bpm->NewPage(&page_ids[i])->GetData(), i);
+      bpm->UnpinPage(page_ids[i], true);
+    }
+    bpm->FlushAllPages();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ops; i++) {
+      const page_id_t page_id = page_ids[i % num_pages];
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "FetchPage+UnpinPage (miss, " << (cache_size == 0 ? "disk" : "compressed cache")
+              << "): " << ns / num_ops << " ns/op" << std::endl;
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+auto BackingName(FrameBacking backing) -> const char * {
+  switch (backing) {
+    case FrameBacking::HUGETLB:
+      return "hugetlb";
+    case FrameBacking::TRANSPARENT_HUGE_PAGES:
+      return "transparent huge pages";
+    case FrameBacking::REGULAR_PAGES:
+      break;
+  }
+  return "regular pages";
+}
+}  // namespace
+
+/** Counts the data TLB misses of the calling thread, if the kernel lets us read hardware counters. */
+class TlbMissCounter {
+ public:
+  TlbMissCounter() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~TlbMissCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  auto IsValid() const -> bool { return fd_ >= 0; }
+
+  void Start() {
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  auto Stop() -> uint64_t {
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t count = 0;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      return 0;
+    }
+    return count;
+  }
+
+ private:
+  int fd_{-1};
+};
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, AllocateTest) {
+  // Scenario: a small arena is backed by regular pages, a large one asks for huge pages and is aligned for them.
+  FrameArena small(10 * PAGE_SIZE);
+  EXPECT_EQ(FrameBacking::REGULAR_PAGES, small.GetBacking());
+  EXPECT_EQ(FrameArena::NO_NUMA_NODE, small.GetNumaNode());
+
+  const size_t size = 3 * FrameArena::HUGE_PAGE_SIZE + 100;
+  FrameArena large(size);
+  if (large.GetBacking() != FrameBacking::REGULAR_PAGES) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(large.Data()) % FrameArena::HUGE_PAGE_SIZE);
+  }
+  FrameArena regular(size, FrameArena::NO_NUMA_NODE, false);
+  EXPECT_EQ(FrameBacking::REGULAR_PAGES, regular.GetBacking());
+
+  // Scenario: the memory starts zeroed and is usable up to the last byte.
+  for (FrameArena *arena : {&small, &large, &regular}) {
+    const size_t arena_size = arena == &small ? 10 * PAGE_SIZE : size;
+    EXPECT_EQ(0, arena->Data()[0]);
+    EXPECT_EQ(0, arena->Data()[arena_size - 1]);
+    memset(arena->Data(), 'x', arena_size);
+    EXPECT_EQ('x', arena->Data()[arena_size - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, ReleaseTest) {
+  // Scenario: released memory reads as zeros and can be used again; the pages around the range keep their contents.
+  for (const bool huge_pages : {true, false}) {
+    const size_t size = 4 * FrameArena::HUGE_PAGE_SIZE;
+    FrameArena arena(size, FrameArena::NO_NUMA_NODE, huge_pages);
+    memset(arena.Data(), 'x', size);
+    const size_t unit = arena.GetBacking() == FrameBacking::HUGETLB ? FrameArena::HUGE_PAGE_SIZE : PAGE_SIZE;
+    arena.Release(arena.Data() + unit, 2 * unit);
+    EXPECT_EQ('x', arena.Data()[unit - 1]);
+    EXPECT_EQ(0, arena.Data()[unit]);
+    EXPECT_EQ(0, arena.Data()[3 * unit - 1]);
+    EXPECT_EQ('x', arena.Data()[3 * unit]);
+    arena.Data()[unit] = 'y';
+    EXPECT_EQ('y', arena.Data()[unit]);
+
+    // A range smaller than a page releases nothing.
+    arena.Release(arena.Data() + 3 * unit + 1, unit - 2);
+    EXPECT_EQ('x', arena.Data()[3 * unit + 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, NumaTest) {
+  ASSERT_GE(FrameArena::NumaNodeCount(), 1);
+
+  // Scenario: every machine has node 0. Binding may still be refused, e.g. in a container; then the arena says so.
+  FrameArena arena(FrameArena::HUGE_PAGE_SIZE, 0);
+  EXPECT_TRUE(arena.GetNumaNode() == 0 || arena.GetNumaNode() == FrameArena::NO_NUMA_NODE);
+  memset(arena.Data(), 'x', FrameArena::HUGE_PAGE_SIZE);
+
+  // Scenario: a thread can be bound to node 0, unless that is refused as well, but never to a node that does not exist.
+  std::thread thread([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+  FrameArena::BindThread(&thread, 0);
+  thread.join();
+  std::thread nowhere([] {});
+  EXPECT_FALSE(FrameArena::BindThread(&nowhere, 1 << 20));
+  nowhere.join();
+
+  // Scenario: a NUMA aware parallel BPM places its instances round robin over the nodes and works as usual.
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(4, 16, disk_manager, nullptr, PageRouting::MODULO,
+                                            PageRouter::DEFAULT_EXTENT_SIZE, true);
+  for (int i = 0; i < 64; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    const int numa_node = bpm->GetNumaNode(page_id);
+    EXPECT_TRUE(numa_node == FrameArena::NO_NUMA_NODE || numa_node == page_id % 4 % FrameArena::NumaNodeCount());
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id = 0; page_id < 64; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Random reads of one word per frame over a pool much larger than the TLB reach of regular pages, the access pattern
+// of index lookups over a large buffer pool.
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, DISABLED_TlbBenchmarkTest) {
+  const size_t num_frames = 32768;
+  const int num_ops = 2000000;
+
+  for (const bool huge_pages : {false, true}) {
+    FrameArena arena(num_frames * PAGE_SIZE, FrameArena::NO_NUMA_NODE, huge_pages);
+    for (size_t i = 0; i < num_frames; i++) {
+      memset(arena.Data() + i * PAGE_SIZE, static_cast<int>(i), PAGE_SIZE);
+    }
+
+    TlbMissCounter tlb_misses;
+    std::mt19937 engine(0);
+    uint64_t sum = 0;
+    if (tlb_misses.IsValid()) {
+      tlb_misses.Start();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ops; i++) {
+      sum += static_cast<unsigned char>(arena.Data()[engine() % num_frames * PAGE_SIZE + i % PAGE_SIZE]);
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << BackingName(arena.GetBacking()) << ": " << ns / num_ops << " ns/op";
+    if (tlb_misses.IsValid()) {
+      std::cout << ", " << static_cast<double>(tlb_misses.Stop()) / num_ops << " dTLB misses/op";
+    } else {
+      std::cout << ", dTLB misses n/a";
+    }
+    std::cout << " (checksum " << sum % 10 << ")" << std::endl;
+  }
+}
+
+}  // namespace bustub
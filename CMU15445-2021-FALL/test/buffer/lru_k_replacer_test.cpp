@@ -0,0 +1,210 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1-5 are accessed once, frames 1 and 2 a second time, in that order.
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(1);
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // Scenario: frames seen once go first, oldest access first; then the frame whose second-to-last access is oldest.
+  std::vector<frame_id_t> next_victims;
+  lru_k_replacer.NextVictims(4, &next_victims);
+  EXPECT_EQ((std::vector<frame_id_t>{3, 4, 5, 1}), next_victims);
+
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: pinning removes a frame from the eviction order and counts as an access.
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(4);
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: a victimized frame starts over with an empty history.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: a removed frame is no longer evictable.
+  lru_k_replacer.Remove(4);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, 0, ReplacerType::LRU_K, 2);
+
+  // Scenario: a page that is fetched again after it was created has been accessed twice.
+  page_id_t hot_page_id;
+  Page *page = bpm->NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "hot");
+  ASSERT_TRUE(bpm->UnpinPage(hot_page_id, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+  ASSERT_TRUE(bpm->UnpinPage(hot_page_id, false));
+
+  // Scenario: a scan over twice as many pages as the pool holds only recycles the frames of other scanned pages.
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // The hot page is still resident: its dirty image was never written, so the disk copy is not what we get back.
+  page = bpm->FetchPage(hot_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+  char disk_data[PAGE_SIZE];
+  disk_manager->ReadPage(hot_page_id, disk_data);
+  EXPECT_NE(0, strcmp(disk_data, "hot"));
+  ASSERT_TRUE(bpm->UnpinPage(hot_page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** Draws page ids in [0, n) following a Zipfian distribution with exponent theta. */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(size_t n, double theta, uint32_t seed) : cdf_(n), engine_(seed) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (auto &c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  auto Next() -> page_id_t {
+    const double u = std::uniform_real_distribution<double>(0, 1)(engine_);
+    return static_cast<page_id_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin());
+  }
+
+ private:
+  std::vector<double> cdf_;
+  std::mt19937 engine_;
+};
+
+/**
+ * Replays point lookups mixed with a sequential scan against a cache of num_frames frames managed by the replacer,
+ * the same way the buffer pool drives it, and returns the hit ratio of the point lookups.
+ */
+auto PointLookupHitRatio(Replacer *replacer, size_t num_frames) -> double {
+  const int num_lookups = 200000;
+  const int hot_pages = 1000;
+  const int scan_pages_per_lookup = 2;
+
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(num_frames, INVALID_PAGE_ID);
+  size_t used_frames = 0;
+  auto access = [&](page_id_t page_id) {
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+      replacer->Pin(it->second);
+      replacer->Unpin(it->second);
+      return true;
+    }
+    frame_id_t frame_id;
+    if (used_frames < num_frames) {
+      frame_id = static_cast<frame_id_t>(used_frames++);
+    } else {
+      EXPECT_TRUE(replacer->Victim(&frame_id));
+      page_table.erase(frame_pages[frame_id]);
+    }
+    frame_pages[frame_id] = page_id;
+    page_table[page_id] = frame_id;
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+    return false;
+  };
+
+  ZipfianGenerator zipf(hot_pages, 0.99, 15445);
+  page_id_t scan_page_id = hot_pages;
+  int hits = 0;
+  for (int i = 0; i < num_lookups; i++) {
+    if (access(zipf.Next())) {
+      hits++;
+    }
+    for (int j = 0; j < scan_pages_per_lookup; j++) {
+      access(scan_page_id++);
+    }
+  }
+  return static_cast<double>(hits) / num_lookups;
+}
+
+// Point lookups over a Zipfian hot set compete with a large sequential scan for the same frames. LRU lets every
+// scanned page push out hot pages; LRU-K evicts the scanned pages first because they are never seen twice.
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, ScanMixHitRatioTest) {
+  const size_t num_frames = 256;
+
+  LRUReplacer lru_replacer(num_frames);
+  const double lru_hit_ratio = PointLookupHitRatio(&lru_replacer, num_frames);
+
+  double best_hit_ratio = 0;
+  for (size_t k = 2; k <= 3; k++) {
+    LRUKReplacer lru_k_replacer(num_frames, k);
+    const double lru_k_hit_ratio = PointLookupHitRatio(&lru_k_replacer, num_frames);
+    best_hit_ratio = std::max(best_hit_ratio, lru_k_hit_ratio);
+  }
+  EXPECT_GT(best_hit_ratio, lru_hit_ratio);
+}
+
+}  // namespace bustub
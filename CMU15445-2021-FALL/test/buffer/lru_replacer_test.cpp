@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -59,4 +62,42 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// Measures the replacer operations on the buffer pool hot path: a hit pins and unpins a frame, an eviction takes a
+// victim and unpins the frame once its new page is loaded.
+// NOLINTNEXTLINE
+TEST(LRUReplacerTest, DISABLED_HotPathBenchmarkTest) {
+  const size_t num_frames = 4096;
+  const int num_ops = 1000000;
+  LRUReplacer lru_replacer(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    lru_replacer.Unpin(static_cast<frame_id_t>(i));
+  }
+
+  std::mt19937 engine(15445);
+  std::uniform_int_distribution<frame_id_t> dist(0, num_frames - 1);
+  std::vector<frame_id_t> frames(num_ops);
+  for (auto &frame_id : frames) {
+    frame_id = dist(engine);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (const frame_id_t frame_id : frames) {
+    lru_replacer.Pin(frame_id);
+    lru_replacer.Unpin(frame_id);
+  }
+  auto pin_unpin_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(lru_replacer.Victim(&frame_id));
+    lru_replacer.Unpin(frame_id);
+  }
+  auto victim_unpin_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "Pin+Unpin: " << pin_unpin_ns / num_ops << " ns/op" << std::endl;
+  std::cout << "Victim+Unpin: " << victim_unpin_ns / num_ops << " ns/op" << std::endl;
+  EXPECT_EQ(num_frames, lru_replacer.Size());
+}
+
 }  // namespace bustub
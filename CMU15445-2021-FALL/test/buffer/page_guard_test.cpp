@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/buffer/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_guard.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+/** @return the pin count of a resident page, not counting the pin taken to look at it */
+auto PinCount(BufferPoolManager *bpm, page_id_t page_id) -> int {
+  Page *page = bpm->FetchPage(page_id);
+  const int pin_count = page->GetPinCount() - 1;
+  bpm->UnpinPage(page_id, false);
+  return pin_count;
+}
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, PinTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+
+  // Scenario: a new page's guard unpins it dirty at the end of its scope.
+  page_id_t page_id;
+  {
+    WritePageGuard guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "guarded");
+  }
+  EXPECT_EQ(0, PinCount(bpm, page_id));
+
+  // Scenario: read guards share the page and each hold a pin until dropped.
+  {
+    ReadPageGuard first = bpm->FetchPageRead(page_id);
+    ReadPageGuard second = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, PinCount(bpm, page_id));
+    EXPECT_EQ("guarded", std::string(second.GetData()));
+    first.Drop();
+    first.Drop();
+    EXPECT_FALSE(first.IsValid());
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+  }
+  EXPECT_EQ(0, PinCount(bpm, page_id));
+
+  // Scenario: moving a guard hands over the pin; assigning to a guard releases the page it held.
+  page_id_t other_page_id;
+  bpm->NewPageGuarded(&other_page_id);
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    ReadPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+    moved = bpm->FetchPageRead(other_page_id);
+    EXPECT_EQ(0, PinCount(bpm, page_id));
+    EXPECT_EQ(1, PinCount(bpm, other_page_id));
+    std::vector<ReadPageGuard> guards;
+    guards.push_back(std::move(moved));
+    guards.push_back(bpm->FetchPageRead(page_id));
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+  }
+  EXPECT_EQ(0, PinCount(bpm, page_id));
+  EXPECT_EQ(0, PinCount(bpm, other_page_id));
+
+  // Scenario: when the pool is full of pinned pages, guards come back invalid instead of leaking anything.
+  std::vector<WritePageGuard> guards;
+  for (int i = 0; i < 4; i++) {
+    page_id_t new_page_id;
+    guards.push_back(bpm->NewPageGuarded(&new_page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  page_id_t new_page_id;
+  EXPECT_FALSE(bpm->NewPageGuarded(&new_page_id).IsValid());
+  EXPECT_FALSE(bpm->FetchPageWrite(page_id).IsValid());
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+  guards.clear();
+  EXPECT_TRUE(bpm->FetchPageRead(page_id).IsValid());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, DirtyTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  page_id_t page_id;
+  bpm->NewPageGuarded(&page_id);
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+
+  // Scenario: a write guard only unpins the page dirty if it was accessed for writing or marked dirty.
+  bpm->FetchPageWrite(page_id).As<char>();
+  Page *page = bpm->FetchPage(page_id);
+  EXPECT_FALSE(page->IsDirty());
+  bpm->UnpinPage(page_id, false);
+
+  bpm->FetchPageWrite(page_id).AsMut<char>()[0] = 'x';
+  page = bpm->FetchPage(page_id);
+  EXPECT_TRUE(page->IsDirty());
+  bpm->UnpinPage(page_id, false);
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    guard.MarkDirty();
+  }
+  page = bpm->FetchPage(page_id);
+  EXPECT_TRUE(page->IsDirty());
+  bpm->UnpinPage(page_id, false);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, LatchTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(2, 4, disk_manager);
+  page_id_t page_id;
+  bpm->NewPageGuarded(&page_id);
+
+  // Scenario: a write guard keeps readers out until it is dropped.
+  WritePageGuard write_guard = bpm->FetchPageWrite(page_id);
+  std::atomic<bool> read{false};
+  std::thread reader([&] {
+    ReadPageGuard read_guard = bpm->FetchPageRead(page_id);
+    read = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(read.load());
+  write_guard.Drop();
+  reader.join();
+  EXPECT_TRUE(read.load());
+
+  // Scenario: many threads insert under write guards; no update is lost and no pin is left behind.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; i++) {
+        WritePageGuard guard = bpm->FetchPageWrite(page_id);
+        guard.AsMut<int>()[0]++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4000, bpm->FetchPageRead(page_id).As<int>()[0]);
+  EXPECT_EQ(0, PinCount(bpm, page_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
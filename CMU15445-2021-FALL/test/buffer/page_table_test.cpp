@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(10);
+  frame_id_t frame_id;
+
+  // Scenario: pages of one instance are strided by the number of instances.
+  for (int i = 0; i < 10; i++) {
+    page_table.Insert(i * 4 + 1, i);
+  }
+  EXPECT_EQ(10, page_table.Size());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(page_table.Find(i * 4 + 1, &frame_id));
+    EXPECT_EQ(i, frame_id);
+  }
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  EXPECT_FALSE(page_table.Find(41, &frame_id));
+
+  // Scenario: erased pages are gone, the others are still reachable past the tombstones.
+  for (int i = 0; i < 10; i += 2) {
+    EXPECT_TRUE(page_table.Erase(i * 4 + 1));
+  }
+  EXPECT_FALSE(page_table.Erase(1));
+  EXPECT_EQ(5, page_table.Size());
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i % 2 == 1, page_table.Find(i * 4 + 1, &frame_id));
+  }
+
+  // Scenario: churning through many more pages than slots forces compactions and loses nothing.
+  for (int i = 100; i < 10000; i++) {
+    page_table.Insert(i, i % 5);
+    ASSERT_TRUE(page_table.Erase(i));
+  }
+  EXPECT_EQ(5, page_table.Size());
+  for (int i = 1; i < 10; i += 2) {
+    ASSERT_TRUE(page_table.Find(i * 4 + 1, &frame_id));
+    EXPECT_EQ(i, frame_id);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ConcurrentReadTest) {
+  const int num_stable = 32;
+  PageTable page_table(64);
+  for (int i = 0; i < num_stable; i++) {
+    page_table.Insert(i, i);
+  }
+
+  // Readers must always find the stable pages while a writer keeps inserting, erasing and compacting around them.
+  std::atomic<bool> stop{false};
+  std::atomic<int> misses{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&] {
+      frame_id_t frame_id;
+      while (!stop) {
+        for (int i = 0; i < num_stable; i++) {
+          if (!page_table.Find(i, &frame_id) || frame_id != i) {
+            misses++;
+          }
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 200000; i++) {
+    page_table.Insert(num_stable + i, 0);
+    page_table.Erase(num_stable + i);
+  }
+  stop = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, misses);
+}
+
+// Measures FetchPage/UnpinPage throughput on resident pages as threads are added. The hit path does not take the
+// instance latch, so throughput should grow with the thread count instead of collapsing on the mutex.
+// NOLINTNEXTLINE
+TEST(PageTableTest, DISABLED_HitPathScalingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int ops_per_thread = 200000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    Page *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_ids[i]);
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+
+  const size_t max_threads = std::max(1U, std::thread::hardware_concurrency());
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::atomic<int> errors{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        char expected[PAGE_SIZE];
+        for (int i = 0; i < ops_per_thread; i++) {
+          page_id_t page_id = page_ids[(t * 7 + i) % buffer_pool_size];
+          Page *page = bpm->FetchPage(page_id);
+          snprintf(expected, PAGE_SIZE, "page %d", page_id);
+          if (page == nullptr || strcmp(page->GetData(), expected) != 0) {
+            errors++;
+            continue;
+          }
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0, errors);
+    std::cout << "threads: " << num_threads << ", fetch+unpin/s: " << num_threads * ops_per_thread / elapsed
+              << std::endl;
+  }
+
+  // Every pin was released, so the whole pool can be recycled.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -11,10 +11,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/page_router.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -82,6 +92,7 @@ TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
 
   delete bpm;
   delete disk_manager;
@@ -146,9 +157,483 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
 
   delete bpm;
   delete disk_manager;
 }
 
+/** Counts the writes the buffer pool issues, and the runs of adjacent pages WritePages() coalesced them into. */
+class CountingDiskManager : public DiskManager {
+ public:
+  explicit CountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    single_writes_++;
+    DiskManager::WritePage(page_id, page_data);
+  }
+
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> *pages) override {
+    batched_pages_ += pages->size();
+    coalesced_writes_ += CoalescePages(pages).size();
+    DiskManager::WritePages(pages);
+  }
+
+  std::atomic<size_t> single_writes_{0};
+  std::atomic<size_t> batched_pages_{0};
+  std::atomic<size_t> coalesced_writes_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new CountingDiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: consecutive pages are spread over all instances, but flushing writes them in runs.
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    // Keep every other page pinned: pinned pages are flushed too.
+    if (page_id % 2 == 0) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, disk_manager->single_writes_);
+  EXPECT_EQ(buffer_pool_size * num_instances, disk_manager->batched_pages_);
+  EXPECT_LT(disk_manager->coalesced_writes_ * 4, disk_manager->batched_pages_);
+
+  char data[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size * num_instances); i++) {
+    disk_manager->ReadPage(i, data);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(data, expected));
+  }
+
+  // Scenario: only pages dirtied since the last flush are written again.
+  Page *page = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "page 7 again");
+  ASSERT_TRUE(bpm->UnpinPage(7, true));
+  ASSERT_TRUE(bpm->UnpinPage(7, false));
+  bpm->FlushAllPages();
+  EXPECT_EQ(buffer_pool_size * num_instances + 1, disk_manager->batched_pages_);
+  disk_manager->ReadPage(7, data);
+  EXPECT_EQ(0, strcmp(data, "page 7 again"));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrentFlushTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+  const int num_pages = 128;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: flushes run while pages are updated and evicted; every page ends up with its last update on disk.
+  std::atomic<bool> done{false};
+  std::thread flusher([&] {
+    while (!done) {
+      bpm->FlushAllPages();
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < 20; round++) {
+        for (page_id_t page_id = tid; page_id < num_pages; page_id += num_threads) {
+          Page *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          page->WLatch();
+          snprintf(page->GetData(), PAGE_SIZE, "page %d round %d", page_id, round);
+          page->WUnlatch();
+          bpm->UnpinPage(page_id, true);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  flusher.join();
+  bpm->FlushAllPages();
+
+  char data[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    disk_manager->ReadPage(page_id, data);
+    snprintf(expected, PAGE_SIZE, "page %d round %d", page_id, 19);
+    EXPECT_EQ(0, strcmp(data, expected)) << data;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NearlyFullPoolTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 100;
+  const size_t num_instances = 4;
+  const size_t num_free = buffer_pool_size * num_instances / 20;
+  const int num_threads = 4;
+  const int num_ops = 20000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(buffer_pool_size * num_instances);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  // 95% of the pool stays pinned, and only the last instance has frames left.
+  size_t freed = 0;
+  for (page_id_t page_id : page_ids) {
+    if (freed < num_free && static_cast<size_t>(page_id) % num_instances == num_instances - 1) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      ASSERT_TRUE(bpm->DeletePage(page_id));
+      freed++;
+    }
+  }
+
+  // Scenario: every allocation skips the full instances and succeeds in the last one.
+  std::atomic<int> failed{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_ops; i++) {
+        page_id_t page_id;
+        if (bpm->NewPage(&page_id) == nullptr) {
+          failed++;
+          continue;
+        }
+        if (static_cast<size_t>(page_id) % num_instances != num_instances - 1) {
+          failed++;
+        }
+        bpm->UnpinPage(page_id, false);
+        bpm->DeletePage(page_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, failed);
+
+  // Scenario: once the last frames are taken, NewPage fails without touching any instance.
+  std::vector<page_id_t> extra(num_free);
+  for (auto &page_id : extra) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(0, static_cast<size_t>(page_id) % num_instances);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_NearlyFullPoolBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 100;
+  const size_t num_instances = 4;
+  const size_t num_free = buffer_pool_size * num_instances / 20;
+  const int num_threads = 4;
+  const int num_ops = 20000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(buffer_pool_size * num_instances);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  // 95% of the pool stays pinned, and only the last instance has frames left.
+  size_t freed = 0;
+  for (page_id_t page_id : page_ids) {
+    if (freed < num_free && static_cast<size_t>(page_id) % num_instances == num_instances - 1) {
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      ASSERT_TRUE(bpm->DeletePage(page_id));
+      freed++;
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_ops; i++) {
+        page_id_t page_id;
+        if (bpm->NewPage(&page_id) != nullptr) {
+          bpm->UnpinPage(page_id, false);
+          bpm->DeletePage(page_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "NewPage+UnpinPage+DeletePage (95% pinned, " << num_threads << " threads): " << ns / num_ops
+            << " ns/op" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, PageRouterTest) {
+  const uint32_t num_instances = 3;
+  const uint32_t extent_size = 4;
+
+  PageRouter modulo(PageRouting::MODULO, num_instances, extent_size);
+  for (page_id_t page_id = 0; page_id < 100; page_id++) {
+    EXPECT_EQ(static_cast<uint32_t>(page_id) % num_instances, modulo.InstanceOf(page_id));
+  }
+
+  PageRouter extent(PageRouting::EXTENT, num_instances, extent_size);
+  for (page_id_t page_id = 0; page_id < 100; page_id++) {
+    EXPECT_EQ(static_cast<uint32_t>(page_id) / extent_size % num_instances, extent.InstanceOf(page_id));
+  }
+  EXPECT_EQ(4, extent.FirstPageId(1));
+  EXPECT_EQ(5, extent.NextPageId(4, 1));
+  EXPECT_EQ(16, extent.NextPageId(7, 1));
+
+  // Scenario: walking the page ids of every instance visits every page id exactly once, whatever the routing.
+  for (auto routing : {PageRouting::MODULO, PageRouting::EXTENT, PageRouting::HASH}) {
+    PageRouter router(routing, num_instances, extent_size);
+    std::vector<int> owners(1000, -1);
+    for (uint32_t i = 0; i < num_instances; i++) {
+      for (page_id_t page_id = router.FirstPageId(i); page_id < 1000; page_id = router.NextPageId(page_id, i)) {
+        EXPECT_EQ(i, router.InstanceOf(page_id));
+        EXPECT_EQ(-1, owners[page_id]);
+        owners[page_id] = static_cast<int>(i);
+      }
+    }
+    EXPECT_EQ(owners.end(), std::find(owners.begin(), owners.end(), -1));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentRoutingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 3;
+  const uint32_t extent_size = 4;
+  const int num_pages = 60;
+
+  for (auto routing : {PageRouting::EXTENT, PageRouting::HASH}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr, routing,
+                                              extent_size);
+
+    // Scenario: consecutive new pages fill an extent before moving on, so they are adjacent on disk.
+    std::vector<page_id_t> page_ids(num_pages);
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->NewPage(&page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_ids[i]);
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+      if (i % extent_size != 0) {
+        EXPECT_EQ(page_ids[i - 1] + 1, page_ids[i]);
+      }
+    }
+    if (routing == PageRouting::EXTENT) {
+      for (int i = 0; i < num_pages; i++) {
+        EXPECT_EQ(i, page_ids[i]);
+      }
+    }
+
+    // Scenario: the pages were evicted to make room for each other, and come back with their data.
+    for (page_id_t page_id : page_ids) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_RoutingBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_instances = 4;
+  const int num_pages = 1024;
+  const int num_threads = 4;
+  const int num_rounds = 20;
+
+  for (const auto &[routing, name] : {std::make_pair(PageRouting::MODULO, "MODULO"),
+                                     std::make_pair(PageRouting::EXTENT, "EXTENT"),
+                                     std::make_pair(PageRouting::HASH, "HASH")}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr, routing);
+    std::vector<page_id_t> page_ids(num_pages);
+    for (auto &page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    bpm->FlushAllPages();
+    std::sort(page_ids.begin(), page_ids.end());
+
+    auto run = [&](const char *workload, const std::function<void(int, std::vector<page_id_t> *)> &next_pages) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&, tid] {
+          std::vector<page_id_t> pages;
+          next_pages(tid, &pages);
+          for (int round = 0; round < num_rounds; round++) {
+            for (page_id_t page_id : pages) {
+              if (bpm->FetchPage(page_id) != nullptr) {
+                bpm->UnpinPage(page_id, false);
+              }
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      std::cout << name << " " << workload << " (" << num_threads << " threads): "
+                << ns / (num_rounds * num_pages / num_threads * num_threads) << " ns/op" << std::endl;
+    };
+    // Each thread scans its own quarter of the pages in order, like concurrent sequential scans of different tables.
+    run("scan", [&](int tid, std::vector<page_id_t> *pages) {
+      const int share = num_pages / num_threads;
+      pages->assign(page_ids.begin() + tid * share, page_ids.begin() + (tid + 1) * share);
+    });
+    // Each thread fetches random pages, like index lookups.
+    run("point", [&](int tid, std::vector<page_id_t> *pages) {
+      std::mt19937 engine(tid);
+      for (int i = 0; i < num_pages / num_threads; i++) {
+        pages->push_back(page_ids[engine() % num_pages]);
+      }
+    });
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 2;
+  const int num_pages = 64;
+  const int num_threads = 4;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, 8, disk_manager, nullptr, PageRouting::MODULO,
+                                            PageRouter::DEFAULT_EXTENT_SIZE, false, 32);
+  EXPECT_EQ(16, bpm->GetPoolSize());
+
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: pages are fetched, checked and rewritten while the pool grows and shrinks; no page is lost or torn.
+  std::atomic<bool> stop{false};
+  std::atomic<int> corrupted{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 engine(tid);
+      while (!stop) {
+        const page_id_t page_id = page_ids[engine() % num_pages];
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          std::this_thread::yield();
+          continue;
+        }
+        page->WLatch();
+        if (std::to_string(page_id) != page->GetData()) {
+          corrupted++;
+        }
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        page->WUnlatch();
+        bpm->UnpinPage(page_id, true);
+      }
+    });
+  }
+  for (size_t new_size : {64, 8, 40, 16, 64, 10}) {
+    EXPECT_TRUE(bpm->Resize(new_size));
+    EXPECT_EQ(new_size, bpm->GetPoolSize());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, corrupted);
+  EXPECT_FALSE(bpm->Resize(1));
+  EXPECT_FALSE(bpm->Resize(65));
+
+  bpm->FlushAllPages();
+  EXPECT_TRUE(bpm->Resize(2));
+  for (const page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
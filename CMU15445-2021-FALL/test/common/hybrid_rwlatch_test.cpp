@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_rwlatch_test.cpp
+//
+// Identification: test/common/hybrid_rwlatch_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/hybrid_rwlatch.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+/** A few words written together, so a reader that overlaps a writer sees them disagree. */
+template <typename Latch>
+class GuardedPair {
+ public:
+  void Write(uint64_t value) {
+    latch_.WLock();
+    first_ = value;
+    second_ = value;
+    latch_.WUnlock();
+  }
+
+  auto Read() -> bool {
+    latch_.RLock();
+    const bool consistent = first_ == second_;
+    latch_.RUnlock();
+    return consistent;
+  }
+
+ private:
+  Latch latch_;
+  volatile uint64_t first_{0};
+  volatile uint64_t second_{0};
+};
+
+/**
+ * Run num_threads threads that each do num_ops latched operations on one shared pair, write_percent of them writes.
+ * @return nanoseconds per operation
+ */
+template <typename Latch>
+auto RunMix(int num_threads, int num_ops, int write_percent) -> double {
+  GuardedPair<Latch> pair;
+  std::atomic<int> inconsistent{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 engine(tid);
+      for (int i = 0; i < num_ops; i++) {
+        if (static_cast<int>(engine() % 100) < write_percent) {
+          pair.Write(i);
+        } else if (!pair.Read()) {
+          inconsistent++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(0, inconsistent.load());
+  return ns / (num_threads * num_ops);
+}
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(HybridRWLatchTest, BasicTest) {
+  // Scenario: readers share the latch, a writer excludes everybody, for both preferences.
+  for (const bool prefer_writers : {true, false}) {
+    HybridReaderWriterLatch latch(prefer_writers);
+    latch.RLock();
+    latch.RLock();
+    std::atomic<bool> written{false};
+    std::thread writer([&] {
+      latch.WLock();
+      written = true;
+      latch.WUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(written.load());
+    latch.RUnlock();
+    latch.RUnlock();
+    writer.join();
+    EXPECT_TRUE(written.load());
+
+    latch.WLock();
+    std::atomic<bool> read{false};
+    std::thread reader([&] {
+      latch.RLock();
+      read = true;
+      latch.RUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(read.load());
+    latch.WUnlock();
+    reader.join();
+    EXPECT_TRUE(read.load());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(HybridRWLatchTest, WriterPreferenceTest) {
+  // Scenario: while a writer waits for a reader, new readers only get in if writers are not preferred.
+  for (const bool prefer_writers : {true, false}) {
+    HybridReaderWriterLatch latch(prefer_writers);
+    latch.RLock();
+    std::thread writer([&] {
+      latch.WLock();
+      latch.WUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<bool> read{false};
+    std::thread reader([&] {
+      latch.RLock();
+      read = true;
+      latch.RUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(!prefer_writers, read.load());
+    latch.RUnlock();
+    writer.join();
+    reader.join();
+    EXPECT_TRUE(read.load());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(HybridRWLatchTest, ConcurrencyTest) {
+  // Scenario: many threads contend long enough for waiters to park; no reader overlaps a writer and no write is lost.
+  const int num_threads = 8;
+  const int num_ops = 20000;
+  RunMix<HybridReaderWriterLatch>(num_threads, num_ops, 50);
+
+  HybridReaderWriterLatch latch;
+  int count = 0;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < num_ops; i++) {
+        latch.WLock();
+        count++;
+        latch.WUnlock();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * num_ops, count);
+}
+
+// Short critical sections like those of bucket page reads, under a read-heavy and a write-heavy mix.
+// NOLINTNEXTLINE
+TEST(HybridRWLatchTest, DISABLED_BenchmarkTest) {
+  const int num_ops = 200000;
+  for (const int num_threads : {1, 4}) {
+    for (const int write_percent : {5, 50}) {
+      const double cv_ns = RunMix<ReaderWriterLatch>(num_threads, num_ops, write_percent);
+      const double hybrid_ns = RunMix<HybridReaderWriterLatch>(num_threads, num_ops, write_percent);
+      std::cout << num_threads << " threads, " << write_percent << "% writes: ReaderWriterLatch " << cv_ns
+                << " ns/op, HybridReaderWriterLatch " << hybrid_ns << " ns/op" << std::endl;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimistic_latch_test.cpp
+//
+// Identification: test/common/optimistic_latch_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/optimistic_latch.h"
+#include "gtest/gtest.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(OptimisticLatchTest, BasicTest) {
+  OptimisticLatch latch;
+  uint64_t version = latch.ReadBegin();
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Scenario: a write in between invalidates the read, a later read validates again.
+  latch.WLock();
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(version));
+  version = latch.ReadBegin();
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Scenario: an upgrade only succeeds from the current version, and invalidates other readers.
+  const uint64_t other = latch.ReadBegin();
+  EXPECT_TRUE(latch.TryUpgrade(version));
+  EXPECT_FALSE(latch.TryUpgrade(version));
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(other));
+
+  // Scenario: write latching a page versions it; read latching does not.
+  Page page;
+  version = page.BeginOptimisticRead();
+  page.RLatch();
+  page.RUnlatch();
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+  page.WLatch();
+  page.WUnlatch();
+  EXPECT_FALSE(page.ValidateOptimisticRead(version));
+}
+
+// NOLINTNEXTLINE
+TEST(OptimisticLatchTest, ConcurrencyTest) {
+  const int num_readers = 4;
+  const int num_writes = 20000;
+  OptimisticLatch latch;
+  // Writers keep both halves equal; relaxed atomics stand in for page data, so the torn reads are well defined.
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0};
+  std::atomic<int> validated{0};
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_readers; tid++) {
+    threads.emplace_back([&] {
+      while (!done) {
+        const uint64_t version = latch.ReadBegin();
+        const int a = first.load(std::memory_order_relaxed);
+        const int b = second.load(std::memory_order_relaxed);
+        if (latch.Validate(version)) {
+          validated++;
+          if (a != b) {
+            torn++;
+          }
+        }
+      }
+    });
+  }
+  std::vector<std::thread> writers;
+  for (int tid = 0; tid < 2; tid++) {
+    writers.emplace_back([&] {
+      for (int i = 0; i < num_writes; i++) {
+        latch.WLock();
+        first.store(first.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        second.store(second.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        latch.WUnlock();
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(2 * num_writes, first.load());
+  EXPECT_EQ(first.load(), second.load());
+  EXPECT_EQ(0, torn);
+  EXPECT_GT(validated, 0);
+}
+
+// Readers of one page, the root of every index lookup: the read latch writes to the latch's cache line twice per
+// read, an optimistic read only loads the version.
+// NOLINTNEXTLINE
+TEST(OptimisticLatchTest, DISABLED_PageReadBenchmarkTest) {
+  const int num_threads = 4;
+  const int num_ops = 1000000;
+  Page page;
+  memset(page.GetData(), 1, PAGE_SIZE);
+
+  for (const bool optimistic : {false, true}) {
+    std::atomic<uint64_t> sum{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&, tid] {
+        uint64_t local = 0;
+        for (int i = 0; i < num_ops; i++) {
+          const size_t offset = (tid * 64 + i) % PAGE_SIZE;
+          if (optimistic) {
+            uint64_t version;
+            char value;
+            do {
+              version = page.BeginOptimisticRead();
+              value = page.GetData()[offset];
+            } while (!page.ValidateOptimisticRead(version));
+            local += value;
+          } else {
+            page.RLatch();
+            local += page.GetData()[offset];
+            page.RUnlatch();
+          }
+        }
+        sum += local;
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(static_cast<uint64_t>(num_threads) * num_ops, sum.load());
+    std::cout << (optimistic ? "optimistic read" : "RLatch") << " (" << num_threads << " threads): " << ns / num_ops
+              << " ns/op" << std::endl;
+  }
+}
+
+}  // namespace bustub
@@ -73,6 +73,7 @@ class GradingRollbackTest : public ::testing::Test {
     // Shut down the disk manager and clean up the transaction.
     disk_manager_->ShutDown();
     remove("executor_test.db");
+    remove("executor_test.space");
     delete txn_;
   };
 
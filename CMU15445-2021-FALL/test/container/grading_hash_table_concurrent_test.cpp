@@ -149,6 +149,7 @@ void InsertTest1Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -190,6 +191,7 @@ void InsertTest2Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -231,6 +233,7 @@ void DeleteTest1Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -270,6 +273,7 @@ void DeleteTest2Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -334,6 +338,7 @@ void MixTest1Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -403,6 +408,7 @@ void MixTest2Call() {
     delete bpm;
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 }
 
@@ -185,6 +185,7 @@ void HashTableLeaderboardTestCall() {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 /*
@@ -52,6 +52,7 @@ TEST(HashTablePageTest, DirectoryPageSampleTest) {
   bpm->UnpinPage(directory_page_id, true, nullptr);
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -110,6 +111,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   bpm->UnpinPage(bucket_page_id, true, nullptr);
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -201,6 +203,7 @@ TEST(HashTablePageTest, HashTablePageIntegratedTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -174,6 +174,7 @@ void ConcurrentScaleTest() {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 void ScaleTestCall() {
@@ -274,6 +275,7 @@ void ScaleTestCall() {
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -116,6 +116,7 @@ TEST(HashTableTest, SampleTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -211,6 +212,7 @@ void InsertTestCall(KeyType k /* unused */, ValueType v /* unused */, KeyCompara
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -296,6 +298,7 @@ void RemoveTestCall(KeyType k /* unused */, ValueType v /* unused */, KeyCompara
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -331,6 +334,7 @@ void SplitGrowTestCall(KeyType k /* unused */, ValueType v /* unused */, KeyComp
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -433,6 +437,7 @@ void GrowShrinkTestCall(KeyType k /* unused */, ValueType v /* unused */, KeyCom
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
@@ -555,6 +560,7 @@ TEST(HashTableTest, IntegratedConcurrencyTest) {
     delete ht;
     disk_manager->ShutDown();
     remove("test.db");
+    remove("test.space");
     delete disk_manager;
     delete bpm;
   }
@@ -633,6 +639,7 @@ TEST(HashTableTest, GrowShrinkConcurrencyTest) {
     delete ht;
     disk_manager->ShutDown();
     remove("test.db");
+    remove("test.space");
     delete disk_manager;
     delete bpm;
   }
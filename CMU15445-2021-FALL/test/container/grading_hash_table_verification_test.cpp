@@ -57,6 +57,7 @@ TEST(HashTableVerificationTest, DiskManagerTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.space");
   delete disk_manager;
   delete bpm;
 }
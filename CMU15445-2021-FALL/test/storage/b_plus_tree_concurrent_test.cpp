@@ -150,6 +150,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
@@ -201,6 +202,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
@@ -243,6 +245,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
@@ -286,6 +289,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
@@ -331,6 +335,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 }  // namespace bustub
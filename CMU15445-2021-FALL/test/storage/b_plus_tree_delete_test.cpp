@@ -96,6 +96,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 
 TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
@@ -174,5 +175,6 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 }  // namespace bustub
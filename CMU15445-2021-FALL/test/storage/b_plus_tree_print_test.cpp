@@ -114,5 +114,6 @@ TEST(BptTreeTest, DISABLED_UnitTest) {
   delete disk_manager;
   remove("test.db");
   remove("test.log");
+  remove("test.space");
 }
 }  // namespace bustub
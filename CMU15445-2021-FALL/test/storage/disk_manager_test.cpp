@@ -10,10 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+
 #include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/direct_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -24,12 +30,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.space");
   };
 };
 
@@ -75,4 +83,149 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectReadWritePageTest) {
+  for (bool use_io_uring : {true, false}) {
+    // One spare alignment unit lets a misaligned pointer into each buffer still have a whole page after it.
+    alignas(DirectDiskManager::DIRECT_IO_ALIGNMENT) char buf[PAGE_SIZE + DirectDiskManager::DIRECT_IO_ALIGNMENT] = {0};
+    alignas(DirectDiskManager::DIRECT_IO_ALIGNMENT) char data[PAGE_SIZE + DirectDiskManager::DIRECT_IO_ALIGNMENT] = {0};
+    auto dm = DirectDiskManager("test.db", use_io_uring);
+    EXPECT_FALSE(!use_io_uring && dm.UsesIoUring());
+    std::strncpy(data, "A test string.", PAGE_SIZE);
+
+    std::memset(buf, 1, PAGE_SIZE);
+    dm.ReadPage(0, buf);  // tolerate empty read
+    EXPECT_EQ(0, buf[0]);
+
+    dm.WritePage(0, data);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+
+    std::memset(buf, 0, PAGE_SIZE);
+    dm.WritePage(5, data);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+    EXPECT_EQ(2, dm.GetNumWrites());
+
+    // Scenario: buffers that are not aligned for O_DIRECT go through an aligned copy.
+    char *unaligned_data = data + 1;
+    std::strncpy(unaligned_data, "Unaligned.", 16);
+    dm.WritePage(3, unaligned_data);
+    char *unaligned_buf = buf + 1;
+    dm.ReadPage(3, unaligned_buf);
+    EXPECT_EQ(std::memcmp(unaligned_buf, unaligned_data, PAGE_SIZE), 0);
+
+    // Scenario: pages written by the direct disk manager are visible to the regular one.
+    dm.ShutDown();
+    auto regular_dm = DiskManager("test.db");
+    regular_dm.ReadPage(5, buf);
+    EXPECT_EQ(0, std::strcmp(buf, "A test string."));
+    regular_dm.ShutDown();
+    remove("test.db");
+    remove("test.space");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  for (int kind = 0; kind < 3; kind++) {
+    DiskManager *dm = kind == 0 ? new DiskManager("test.db") : new DirectDiskManager("test.db", kind == 1);
+    // Pages 3-5 are adjacent on disk but scattered in memory, pages 7 and 8 are adjacent in both.
+    std::vector<char> images(10 * PAGE_SIZE);
+    for (int i = 0; i < 10; i++) {
+      std::memset(&images[i * PAGE_SIZE], 'a' + i, PAGE_SIZE);
+    }
+    std::vector<std::pair<page_id_t, const char *>> pages{{5, &images[0]},
+                                                           {3, &images[2 * PAGE_SIZE]},
+                                                           {8, &images[8 * PAGE_SIZE]},
+                                                           {4, &images[4 * PAGE_SIZE]},
+                                                           {7, &images[7 * PAGE_SIZE]}};
+    dm->WritePages(&pages);
+    EXPECT_EQ(5, dm->GetNumWrites());
+    EXPECT_EQ(3, pages[0].first);
+    EXPECT_EQ(8, pages[4].first);
+
+    char buf[PAGE_SIZE];
+    const std::vector<std::pair<page_id_t, char>> expected{{3, 'c'}, {4, 'e'}, {5, 'a'}, {6, 0}, {7, 'h'}, {8, 'i'}};
+    for (const auto &[page_id, fill] : expected) {
+      dm->ReadPage(page_id, buf);
+      EXPECT_EQ(fill, buf[0]) << "page " << page_id;
+      EXPECT_EQ(fill, buf[PAGE_SIZE - 1]) << "page " << page_id;
+    }
+
+    dm->ShutDown();
+    delete dm;
+    remove("test.db");
+    remove("test.space");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DeallocatePageTest) {
+  const page_id_t num_pages = 64;
+  for (int kind = 0; kind < 3; kind++) {
+    DiskManager *dm = kind == 0 ? new DiskManager("test.db") : new DirectDiskManager("test.db", kind == 1);
+    char data[PAGE_SIZE];
+    std::memset(data, 'x', sizeof(data));
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      dm->WritePage(page_id, data);
+    }
+    struct stat before;
+    ASSERT_EQ(0, stat("test.db", &before));
+
+    // Scenario: deallocated pages read back as zeros, their neighbours are untouched, and the file keeps its size.
+    for (page_id_t page_id = 8; page_id < num_pages - 8; page_id++) {
+      dm->DeallocatePage(page_id);
+    }
+    char buf[PAGE_SIZE];
+    dm->ReadPage(20, buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+    dm->ReadPage(7, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    dm->ReadPage(num_pages - 8, buf);
+    EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+    struct stat after;
+    ASSERT_EQ(0, stat("test.db", &after));
+    EXPECT_EQ(before.st_size, after.st_size);
+    // Scenario: the space goes back to the file system, where it supports punching holes.
+    EXPECT_LE(after.st_blocks, before.st_blocks);
+
+    dm->ShutDown();
+    delete dm;
+    remove("test.db");
+    remove("test.space");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectConcurrentReadWriteTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  auto dm = DirectDiskManager("test.db");
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      alignas(DirectDiskManager::DIRECT_IO_ALIGNMENT) char data[PAGE_SIZE];
+      alignas(DirectDiskManager::DIRECT_IO_ALIGNMENT) char buf[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + tid;
+          std::memset(data, page_id + round, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
 }  // namespace bustub
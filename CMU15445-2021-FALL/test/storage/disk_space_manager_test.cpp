@@ -0,0 +1,291 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_space_manager_test.cpp
+//
+// Identification: test/storage/disk_space_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_space_manager.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+namespace {
+
+const DiskSpaceManager::PageFilter ANY_PAGE = [](page_id_t page_id) { return true; };
+
+/** @return the pages of the table's page list, in list order */
+auto ListPages(BufferPoolManager *bpm, page_id_t first_page_id) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_ids.push_back(page_id);
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  return page_ids;
+}
+
+}  // namespace
+
+class DiskSpaceManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.space");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.space");
+  };
+};
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, AllocateTest) {
+  DiskSpaceManager space_manager("", 0);
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    EXPECT_EQ(page_id, space_manager.AllocatePage(ANY_PAGE));
+  }
+  EXPECT_TRUE(space_manager.IsAllocated(7));
+  EXPECT_FALSE(space_manager.IsAllocated(10));
+
+  // Freed pages come back lowest first, before the file grows.
+  space_manager.DeallocatePage(7);
+  space_manager.DeallocatePage(3);
+  EXPECT_FALSE(space_manager.IsAllocated(7));
+  EXPECT_EQ(3, space_manager.AllocatePage(ANY_PAGE));
+  EXPECT_EQ(7, space_manager.AllocatePage(ANY_PAGE));
+  EXPECT_EQ(10, space_manager.AllocatePage(ANY_PAGE));
+
+  // Pages the caller cannot use are left for others.
+  space_manager.DeallocatePage(5);
+  const auto even = [](page_id_t page_id) { return page_id % 2 == 0; };
+  EXPECT_EQ(12, space_manager.AllocatePage(even));
+  EXPECT_EQ(5, space_manager.AllocatePage(ANY_PAGE));
+  EXPECT_EQ(11, space_manager.AllocatePage(ANY_PAGE));
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, ExtentTest) {
+  const auto extent_size = static_cast<page_id_t>(DiskSpaceManager::EXTENT_SIZE);
+  DiskSpaceManager space_manager("", 0);
+  DiskExtent a;
+  DiskExtent b;
+
+  // Interleaved allocations still give every owner adjacent pages.
+  for (page_id_t i = 0; i < extent_size; i++) {
+    EXPECT_EQ(i, space_manager.AllocatePage(&a, ANY_PAGE));
+    EXPECT_EQ(extent_size + i, space_manager.AllocatePage(&b, ANY_PAGE));
+  }
+  // Reserved pages are not handed out to others.
+  EXPECT_EQ(2 * extent_size, space_manager.AllocatePage(ANY_PAGE));
+  EXPECT_EQ(2 * extent_size + 1, space_manager.AllocatePage(&a, ANY_PAGE));
+  EXPECT_EQ(3 * extent_size, space_manager.AllocatePage(ANY_PAGE));
+
+  // A released extent gives its unused pages back.
+  space_manager.ReleaseExtent(&a);
+  EXPECT_EQ(INVALID_PAGE_ID, a.next_page_id_);
+  EXPECT_EQ(2 * extent_size + 2, space_manager.AllocatePage(ANY_PAGE));
+
+  // Holes are filled before the file grows, even when only a few pages of an extent are free.
+  space_manager.DeallocatePage(5);
+  DiskExtent c;
+  EXPECT_EQ(5, space_manager.AllocatePage(&c, ANY_PAGE));
+  EXPECT_EQ(2 * extent_size + 3, space_manager.AllocatePage(&c, ANY_PAGE));
+  space_manager.ReleaseExtent(&c);
+
+  // A free extent is handed out as a whole.
+  for (page_id_t page_id = 0; page_id < extent_size; page_id++) {
+    space_manager.DeallocatePage(page_id);
+  }
+  EXPECT_EQ(0, space_manager.AllocatePage(&c, ANY_PAGE));
+  EXPECT_EQ(1, space_manager.AllocatePage(&c, ANY_PAGE));
+  EXPECT_EQ(2 * extent_size + 4, space_manager.AllocatePage(ANY_PAGE));
+
+  // Extents only hold pages the caller can use.
+  DiskExtent d;
+  const auto odd_extents = [extent_size](page_id_t page_id) { return page_id / extent_size % 2 == 1; };
+  EXPECT_EQ(3 * extent_size + 1, space_manager.AllocatePage(&d, odd_extents));
+  for (page_id_t page_id = 3 * extent_size + 2; page_id < 4 * extent_size; page_id++) {
+    space_manager.AllocatePage(&d, odd_extents);
+  }
+  EXPECT_EQ(5 * extent_size, space_manager.AllocatePage(&d, odd_extents));
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, PersistTest) {
+  auto *space_manager = new DiskSpaceManager("test.space", 0);
+  for (page_id_t page_id = 0; page_id < 100; page_id++) {
+    space_manager->AllocatePage(ANY_PAGE);
+  }
+  // The allocation of a page is on disk before the page is.
+  space_manager->SaveAllocation(99);
+  {
+    std::ifstream file("test.space", std::ios::binary);
+    char bits[13] = {0};
+    ASSERT_TRUE(file.read(bits, sizeof(bits)));
+    EXPECT_EQ(0x0F, bits[12]);
+  }
+  for (page_id_t page_id = 10; page_id < 20; page_id++) {
+    space_manager->DeallocatePage(page_id);
+  }
+  delete space_manager;
+
+  space_manager = new DiskSpaceManager("test.space", 100);
+  EXPECT_TRUE(space_manager->IsAllocated(5));
+  EXPECT_FALSE(space_manager->IsAllocated(15));
+  EXPECT_TRUE(space_manager->IsAllocated(99));
+  EXPECT_EQ(10, space_manager->AllocatePage(ANY_PAGE));
+  delete space_manager;
+
+  // A new database file starts over.
+  space_manager = new DiskSpaceManager("test.space", 0);
+  EXPECT_FALSE(space_manager->IsAllocated(5));
+  EXPECT_EQ(0, space_manager->AllocatePage(ANY_PAGE));
+  delete space_manager;
+
+  // Without a saved bitmap, all pages of the database file are in use.
+  remove("test.space");
+  space_manager = new DiskSpaceManager("test.space", 50);
+  EXPECT_TRUE(space_manager->IsAllocated(49));
+  EXPECT_EQ(50, space_manager->AllocatePage(ANY_PAGE));
+  delete space_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, BufferPoolTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < 5; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(i, page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // A deleted page id is handed out again, and creating and deleting pages does not grow the file.
+  ASSERT_TRUE(bpm->DeletePage(2));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(2, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(5, page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    ASSERT_TRUE(bpm->DeletePage(page_id));
+  }
+
+  // After a restart, new pages do not overwrite the old ones.
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager("test.db");
+  bpm = new BufferPoolManagerInstance(10, disk_manager);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(5, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, ParallelExtentTest) {
+  const auto extent_size = static_cast<page_id_t>(DiskSpaceManager::EXTENT_SIZE);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(4, 10, disk_manager, nullptr, PageRouting::EXTENT, 4 * extent_size);
+  DiskExtent extent;
+  page_id_t page_id;
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  for (page_id_t i = 0; i < extent_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &extent));
+    if (i == 0) {
+      first_page_id = page_id;
+    }
+    EXPECT_EQ(first_page_id + i, page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    // Plain pages of all instances go around the extent.
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_FALSE(page_id >= first_page_id && page_id < first_page_id + extent_size);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->ReleaseExtent(&extent);
+  EXPECT_EQ(INVALID_PAGE_ID, extent.next_page_id_);
+
+  // Under MODULO routing, extents would straddle instances; pages are still created, just not adjacent.
+  delete bpm;
+  bpm = new ParallelBufferPoolManager(4, 10, disk_manager);
+  for (int i = 0; i < 8; i++) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &extent));
+    EXPECT_TRUE(disk_manager->GetSpaceManager()->IsAllocated(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskSpaceManagerTest, TableHeapLocalityTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+  const int num_tuples = 2000;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *first = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  auto *second = new TableHeap(bpm, lock_manager, nullptr, transaction);
+
+  // Inserts into two tables take turns, yet each table's pages come in runs of adjacent pages.
+  RID rid;
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(first->InsertTuple(tuple, &rid, transaction));
+    ASSERT_TRUE(second->InsertTuple(tuple, &rid, transaction));
+  }
+  for (TableHeap *table : {first, second}) {
+    const std::vector<page_id_t> page_ids = ListPages(bpm, table->GetFirstPageId());
+    ASSERT_GT(page_ids.size(), 2 * DiskSpaceManager::EXTENT_SIZE);
+    size_t num_jumps = 0;
+    for (size_t i = 1; i < page_ids.size(); i++) {
+      num_jumps += page_ids[i] != page_ids[i - 1] + 1 ? 1 : 0;
+    }
+    EXPECT_LE(num_jumps, page_ids.size() / (DiskSpaceManager::EXTENT_SIZE / 2));
+  }
+
+  delete first;
+  delete second;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  delete transaction;
+}
+
+}  // namespace bustub
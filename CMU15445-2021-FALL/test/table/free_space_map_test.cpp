@@ -0,0 +1,383 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/table/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, PageTest) {
+  std::vector<char> data(PAGE_SIZE);
+  auto *page = reinterpret_cast<FreeSpaceMapPage *>(data.data());
+  page->Init(7);
+  EXPECT_EQ(7, page->GetPageId());
+  EXPECT_EQ(INVALID_PAGE_ID, page->GetNextPageId());
+  EXPECT_EQ(0, page->FindSlot(0));
+
+  // Scenario: the first slot with enough room is found; a category nobody has is not.
+  EXPECT_EQ(0, page->Append(100, 3));
+  EXPECT_EQ(1, page->Append(101, 9));
+  EXPECT_EQ(2, page->Append(102, 5));
+  EXPECT_EQ(9, page->GetMaxCategory());
+  EXPECT_EQ(0, page->FindSlot(3));
+  EXPECT_EQ(1, page->FindSlot(4));
+  EXPECT_EQ(3, page->FindSlot(10));
+
+  // Scenario: the largest category follows the entries down and up.
+  page->SetCategory(1, 0);
+  EXPECT_EQ(5, page->GetMaxCategory());
+  EXPECT_EQ(2, page->FindSlot(4));
+  page->SetCategory(0, 200);
+  EXPECT_EQ(200, page->GetMaxCategory());
+  EXPECT_EQ(0, page->FindSlot(200));
+
+  // Scenario: a page holds CAPACITY entries.
+  while (!page->IsFull()) {
+    page->Append(page->GetCount(), 0);
+  }
+  EXPECT_EQ(FreeSpaceMapPage::CAPACITY, page->GetCount());
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, MapTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  const page_id_t num_heap_pages = 2 * FreeSpaceMapPage::CAPACITY + 10;
+
+  page_id_t first_page_id;
+  {
+    FreeSpaceMap map(bpm);
+    first_page_id = map.GetFirstPageId();
+    EXPECT_EQ(INVALID_PAGE_ID, map.GetLastHeapPageId());
+    EXPECT_EQ(INVALID_PAGE_ID, map.FindPage(1));
+
+    // Scenario: full heap pages are never suggested; the map grows past one page.
+    for (page_id_t heap_page_id = 0; heap_page_id < num_heap_pages; heap_page_id++) {
+      ASSERT_TRUE(map.AddPage(1000 + heap_page_id, 0));
+    }
+    EXPECT_EQ(1000 + num_heap_pages - 1, map.GetLastHeapPageId());
+    EXPECT_EQ(INVALID_PAGE_ID, map.FindPage(1));
+
+    // Scenario: a page that gains room is found, by size, from any map page.
+    const page_id_t far_page_id = 1000 + FreeSpaceMapPage::CAPACITY + 3;
+    map.UpdatePage(1005, 100);
+    EXPECT_EQ(1005, map.FindPage(90));
+    map.UpdatePage(far_page_id, 1000);
+    EXPECT_EQ(far_page_id, map.FindPage(200));
+    EXPECT_EQ(INVALID_PAGE_ID, map.FindPage(1001));
+    EXPECT_EQ(INVALID_PAGE_ID, map.FindPage(PAGE_SIZE));
+    map.UpdatePage(far_page_id, 0);
+
+    // Scenario: free space is rounded down, so a suggested page always has the room asked for.
+    map.UpdatePage(1005, FreeSpaceMap::CATEGORY_SIZE * 2 - 1);
+    EXPECT_EQ(INVALID_PAGE_ID, map.FindPage(FreeSpaceMap::CATEGORY_SIZE * 2 - 1));
+    EXPECT_EQ(1005, map.FindPage(FreeSpaceMap::CATEGORY_SIZE));
+
+    // Scenario: unknown heap pages are ignored.
+    map.UpdatePage(5, 1000);
+  }
+
+  // Scenario: the map reads back from its pages.
+  bpm->FlushAllPages();
+  {
+    FreeSpaceMap map(bpm, first_page_id);
+    EXPECT_EQ(1000 + num_heap_pages - 1, map.GetLastHeapPageId());
+    EXPECT_EQ(1005, map.FindPage(1));
+    map.UpdatePage(1000 + num_heap_pages - 1, 1000);
+    EXPECT_EQ(1000 + num_heap_pages - 1, map.FindPage(200));
+  }
+
+  // Scenario: a lost first page starts the map over.
+  page_id_t other_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+  ASSERT_TRUE(bpm->UnpinPage(other_page_id, false));
+  {
+    FreeSpaceMap map(bpm, other_page_id);
+    EXPECT_EQ(other_page_id, map.GetFirstPageId());
+    EXPECT_EQ(INVALID_PAGE_ID, map.GetLastHeapPageId());
+    ASSERT_TRUE(map.AddPage(3, 500));
+    EXPECT_EQ(3, map.FindPage(400));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, TableHeapTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 1000;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+  const page_id_t first_page_id = table->GetFirstPageId();
+  ASSERT_EQ(first_page_id, rids[0].GetPageId());
+  const page_id_t last_page_id = rids.back().GetPageId();
+
+  // Scenario: space freed on the first page is used once the tail page is full, instead of growing the table further.
+  int num_deleted = 0;
+  for (int i = 0; rids[i].GetPageId() == first_page_id; i += 2) {
+    ASSERT_TRUE(lock_manager->LockExclusive(transaction, rids[i]));
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+    table->ApplyDelete(rids[i], transaction);
+    num_deleted++;
+  }
+  ASSERT_GT(num_deleted, 0);
+  const int tuples_per_page = PAGE_SIZE / TablePage::SpaceNeeded(tuple.GetLength());
+  const int num_refilled = num_deleted + tuples_per_page;
+  int num_on_first_page = 0;
+  RID rid;
+  for (int i = 0; i < num_refilled; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    num_on_first_page += rid.GetPageId() == first_page_id ? 1 : 0;
+  }
+  EXPECT_EQ(num_deleted, num_on_first_page);
+
+  // Scenario: a reopened table keeps its map, and finds its last page either way.
+  const page_id_t map_page_id = table->GetFreeSpaceMapPageId();
+  delete table;
+  bpm->FlushAllPages();
+  for (const page_id_t reopen_map_page_id : {map_page_id, INVALID_PAGE_ID}) {
+    table = new TableHeap(bpm, lock_manager, nullptr, first_page_id, reopen_map_page_id);
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+      EXPECT_GE(rid.GetPageId(), last_page_id);
+    }
+    delete table;
+  }
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id, map_page_id);
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(3 * num_tuples - num_deleted + num_refilled, count);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, ConcurrentInsertTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_threads = 4;
+  const int num_tuples = 5000;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+
+  // Scenario: concurrent inserts all land, each in a slot of its own.
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      Transaction txn(t + 1);
+      for (int i = 0; i < num_tuples; i++) {
+        RID rid;
+        Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(t * num_tuples + i))}, &schema};
+        if (table->InsertTuple(tuple, &rid, &txn)) {
+          rids[t].push_back(rid);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::unordered_set<RID> distinct;
+  for (const auto &thread_rids : rids) {
+    EXPECT_EQ(num_tuples, thread_rids.size());
+    distinct.insert(thread_rids.begin(), thread_rids.end());
+  }
+  EXPECT_EQ(num_threads * num_tuples, distinct.size());
+  int64_t sum = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    sum += itr->GetValue(&schema, 0).GetAs<int64_t>();
+  }
+  EXPECT_EQ(static_cast<int64_t>(num_threads * num_tuples) * (num_threads * num_tuples - 1) / 2, sum);
+
+  // Scenario: the pages the threads were still filling are suggested again once the table is closed and reopened.
+  const page_id_t first_page_id = table->GetFirstPageId();
+  const page_id_t map_page_id = table->GetFreeSpaceMapPageId();
+  delete table;
+  bpm->FlushAllPages();
+  delete new TableHeap(bpm, lock_manager, nullptr, first_page_id, map_page_id);
+  std::unordered_set<page_id_t> found;
+  {
+    FreeSpaceMap map(bpm, map_page_id);
+    page_id_t page_id;
+    while ((page_id = map.FindPage(FreeSpaceMap::CATEGORY_SIZE)) != INVALID_PAGE_ID) {
+      found.insert(page_id);
+      map.UpdatePage(page_id, 0);
+    }
+  }
+  int num_partly_filled = 0;
+  for (const auto &thread_rids : rids) {
+    const page_id_t last_page_id = thread_rids.back().GetPageId();
+    ReadPageGuard guard = bpm->FetchPageRead(last_page_id);
+    ASSERT_TRUE(guard.IsValid());
+    if (guard.As<TablePage>()->GetFreeSpaceRemaining() >= FreeSpaceMap::CATEGORY_SIZE) {
+      num_partly_filled++;
+      EXPECT_EQ(1, found.count(last_page_id));
+    }
+  }
+  EXPECT_GT(num_partly_filled, 0);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, RefillTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 20000;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  Tuple tuple{{Value(TypeId::BIGINT, int64_t{0})}, &schema};
+
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+
+  // Scenario: space freed all over the table, more pages than the pool holds, is refilled before the table grows.
+  for (int i = 0; i < num_tuples; i += 10) {
+    ASSERT_TRUE(lock_manager->LockExclusive(transaction, rids[i]));
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction));
+    table->ApplyDelete(rids[i], transaction);
+  }
+  const page_id_t last_page_id = rids.back().GetPageId();
+  for (int i = 0; i < num_tuples; i += 10) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    ASSERT_LE(rid.GetPageId(), last_page_id);
+  }
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// Measures insert throughput while a table grows to 1M tuples, then refilling space freed all over it.
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, DISABLED_InsertBenchmarkTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 1000000;
+  const int batch_size = 100000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(1024, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto transaction = std::make_unique<Transaction>(0, IsolationLevel::READ_COMMITTED);
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction.get());
+  Tuple tuple{{Value(TypeId::BIGINT, int64_t{0})}, &schema};
+
+  std::vector<RID> rids(num_tuples);
+  for (int batch = 0; batch < num_tuples / batch_size; batch++) {
+    // A transaction per batch, so write sets stay small.
+    transaction = std::make_unique<Transaction>(batch, IsolationLevel::READ_COMMITTED);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = batch * batch_size; i < (batch + 1) * batch_size; i++) {
+      ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction.get()));
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "InsertTuple (tuples " << batch * batch_size << "-" << (batch + 1) * batch_size
+              << "): " << ns / batch_size << " ns/op" << std::endl;
+  }
+
+  // Delete every 10th tuple, then insert as many again: each insert goes to a page that has room.
+  transaction = std::make_unique<Transaction>(num_tuples, IsolationLevel::READ_COMMITTED);
+  for (int i = 0; i < num_tuples; i += 10) {
+    ASSERT_TRUE(lock_manager->LockExclusive(transaction.get(), rids[i]));
+    ASSERT_TRUE(table->MarkDelete(rids[i], transaction.get()));
+    table->ApplyDelete(rids[i], transaction.get());
+  }
+  transaction = std::make_unique<Transaction>(num_tuples + 1, IsolationLevel::READ_COMMITTED);
+  const page_id_t last_page_id = rids.back().GetPageId();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_tuples; i += 10) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction.get()));
+    ASSERT_LE(rid.GetPageId(), last_page_id);
+  }
+  const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "InsertTuple (into freed space): " << ns / (num_tuples / 10) << " ns/op" << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
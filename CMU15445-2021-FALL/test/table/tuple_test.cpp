@@ -11,12 +11,16 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
@@ -66,9 +70,327 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   disk_manager->ShutDown();
   remove("test.db");  // remove db file
   remove("test.log");
+  remove("test.space");
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TableHeapReadAheadTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 20000;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new ParallelBufferPoolManager(2, 10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+
+  // Scenario: a table many times bigger than the buffer pool, spread over both instances.
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(i))}, &schema};
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Scenario: scans with read-ahead along the page chain, with and without a scan ring, still see every tuple once.
+  for (size_t ring_size : {0, 4, 32}) {
+    BufferAccessStrategy strategy(ring_size == 0 ? 1 : ring_size);
+    int64_t count = 0;
+    int64_t sum = 0;
+    for (auto itr = table->Begin(transaction, ring_size == 0 ? nullptr : &strategy); itr != table->End(); ++itr) {
+      count++;
+      sum += itr->GetValue(&schema, 0).GetAs<int64_t>();
+    }
+    EXPECT_EQ(num_tuples, count);
+    EXPECT_EQ(static_cast<int64_t>(num_tuples) * (num_tuples - 1) / 2, sum);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ConcurrentScanTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 5000;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new ParallelBufferPoolManager(2, 50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(i))}, &schema};
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Scenario: scans find their way through pages that an inserter is writing to, and see every committed tuple.
+  std::thread inserter([&] {
+    auto *insert_txn = new Transaction(1);
+    for (int i = num_tuples; i < 2 * num_tuples; ++i) {
+      RID rid;
+      Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(i))}, &schema};
+      table->InsertTuple(tuple, &rid, insert_txn);
+    }
+    delete insert_txn;
+  });
+  for (int scan = 0; scan < 5; scan++) {
+    int64_t count = 0;
+    for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+      const int64_t value = itr->GetValue(&schema, 0).GetAs<int64_t>();
+      EXPECT_TRUE(value >= 0 && value < 2 * num_tuples);
+      count++;
+    }
+    EXPECT_GE(count, num_tuples);
+  }
+  inserter.join();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ParallelInsertTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_threads = 4;
+  const int num_tuples = 5000;
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+
+  // Scenario: threads inserting at once, each into a tail page of its own, never hand out the same RID twice.
+  std::vector<std::vector<RID>> rids(num_threads, std::vector<RID>(num_tuples));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      Transaction txn(t + 1);
+      Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(t))}, &schema};
+      for (int i = 0; i < num_tuples; i++) {
+        ASSERT_TRUE(table->InsertTuple(tuple, &rids[t][i], &txn));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const auto rid_less = [](const RID &a, const RID &b) { return a.Get() < b.Get(); };
+  std::vector<RID> all_rids;
+  for (auto &thread_rids : rids) {
+    std::sort(thread_rids.begin(), thread_rids.end(), rid_less);
+    all_rids.insert(all_rids.end(), thread_rids.begin(), thread_rids.end());
+  }
+  std::sort(all_rids.begin(), all_rids.end(), rid_less);
+  EXPECT_EQ(all_rids.end(), std::adjacent_find(all_rids.begin(), all_rids.end()));
+
+  // Scenario: a scan finds every tuple, at the RID its insert returned.
+  std::vector<std::vector<RID>> scanned(num_threads);
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    const int64_t t = itr->GetValue(&schema, 0).GetAs<int64_t>();
+    ASSERT_TRUE(t >= 0 && t < num_threads);
+    scanned[t].push_back(itr->GetRid());
+  }
+  for (int t = 0; t < num_threads; t++) {
+    std::sort(scanned[t].begin(), scanned[t].end(), rid_less);
+    EXPECT_EQ(rids[t], scanned[t]) << t;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// Measures insert throughput as the number of inserting threads grows; each thread fills a tail page of its own.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_ParallelInsertBenchmarkTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 400000;
+
+  for (const int num_threads : {1, 2, 4, 8}) {
+    auto *transaction = new Transaction(0);
+    auto *disk_manager = new DiskManager("test.db");
+    auto *buffer_pool_manager = new BufferPoolManagerInstance(1024, disk_manager);
+    auto *lock_manager = new LockManager();
+    auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        Transaction txn(t + 1);
+        Tuple tuple{{Value(TypeId::BIGINT, static_cast<int64_t>(t))}, &schema};
+        for (int i = 0; i < num_tuples / num_threads; i++) {
+          RID rid;
+          ASSERT_TRUE(table->InsertTuple(tuple, &rid, &txn));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "InsertTuple (" << num_threads << " threads): " << ns / num_tuples << " ns/op" << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete table;
+    delete lock_manager;
+    delete buffer_pool_manager;
+    delete disk_manager;
+    delete transaction;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, BulkInsertTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 10000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(32, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *txn_manager = new TransactionManager(lock_manager);
+  auto *transaction = txn_manager->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+  auto count_tuples = [&] {
+    int count = 0;
+    for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+      count++;
+    }
+    return count;
+  };
+
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(std::vector<Value>{Value(TypeId::BIGINT, static_cast<int64_t>(i))}, &schema);
+  }
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(Tuple{{Value(TypeId::BIGINT, int64_t{-1})}, &schema}, &rid, transaction));
+
+  // Scenario: loaded tuples follow the existing ones in the table, in order, with a single write record.
+  std::vector<RID> rids;
+  ASSERT_TRUE(table->BulkInsert(tuples.begin(), tuples.end(), transaction, &rids));
+  ASSERT_EQ(num_tuples, rids.size());
+  EXPECT_EQ(2, transaction->GetWriteSet()->size());
+  Tuple tuple;
+  ASSERT_TRUE(table->GetTuple(rids[num_tuples / 2], &tuple, transaction));
+  EXPECT_EQ(num_tuples / 2, tuple.GetValue(&schema, 0).GetAs<int64_t>());
+  int64_t expected = -1;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    EXPECT_EQ(expected++, itr->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  EXPECT_EQ(num_tuples, expected);
+
+  // Scenario: an empty range inserts nothing and leaves no write record.
+  ASSERT_TRUE(table->BulkInsert(tuples.begin(), tuples.begin(), transaction));
+  EXPECT_EQ(2, transaction->GetWriteSet()->size());
+  txn_manager->Commit(transaction);
+  delete transaction;
+
+  // Scenario: an aborted bulk insert leaves the table as it was, and its pages take later inserts.
+  transaction = txn_manager->Begin();
+  rids.clear();
+  ASSERT_TRUE(table->BulkInsert(tuples.begin(), tuples.end(), transaction, &rids));
+  EXPECT_EQ(2 * num_tuples + 1, count_tuples());
+  txn_manager->Abort(transaction);
+  delete transaction;
+  EXPECT_EQ(num_tuples + 1, count_tuples());
+  transaction = txn_manager->Begin();
+  ASSERT_TRUE(table->InsertTuple(tuples[0], &rid, transaction));
+  EXPECT_LE(rid.GetPageId(), rids.back().GetPageId());
+  txn_manager->Commit(transaction);
+  delete transaction;
+
+  // Scenario: a tuple that does not fit fails the whole bulk insert.
+  transaction = txn_manager->Begin();
+  Column big_col{"b", TypeId::VARCHAR, PAGE_SIZE};
+  Schema big_schema{std::vector<Column>{big_col}};
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::VARCHAR, std::string(PAGE_SIZE, 'x'))}, &big_schema);
+  rids.clear();
+  EXPECT_FALSE(table->BulkInsert(tuples.begin(), tuples.end(), transaction, &rids));
+  EXPECT_EQ(TransactionState::ABORTED, transaction->GetState());
+  EXPECT_TRUE(rids.empty());
+  EXPECT_EQ(num_tuples + 2, count_tuples());
+  txn_manager->Abort(transaction);
+  delete transaction;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete txn_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// Measures loading 1M tuples into an empty table one at a time and in bulk.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_BulkInsertBenchmarkTest) {
+  Column col{"a", TypeId::BIGINT};
+  Schema schema{std::vector<Column>{col}};
+  const int num_tuples = 1000000;
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.emplace_back(std::vector<Value>{Value(TypeId::BIGINT, static_cast<int64_t>(i))}, &schema);
+  }
+
+  for (const bool bulk : {false, true}) {
+    auto *transaction = new Transaction(0);
+    auto *disk_manager = new DiskManager("test.db");
+    auto *buffer_pool_manager = new BufferPoolManagerInstance(1024, disk_manager);
+    auto *lock_manager = new LockManager();
+    auto *table = new TableHeap(buffer_pool_manager, lock_manager, nullptr, transaction);
+
+    const auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+      ASSERT_TRUE(table->BulkInsert(tuples.begin(), tuples.end(), transaction));
+    } else {
+      for (const auto &tuple : tuples) {
+        RID rid;
+        ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+      }
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (bulk ? "BulkInsert: " : "InsertTuple: ") << ns / num_tuples << " ns/tuple" << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.space");
+    delete table;
+    delete lock_manager;
+    delete buffer_pool_manager;
+    delete disk_manager;
+    delete transaction;
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,377 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vacuum_test.cpp
+//
+// Identification: test/table/vacuum_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+namespace {
+
+/** Delete a tuple for good, the way a committing transaction does. */
+void DeleteTuple(TableHeap *table, LockManager *lock_manager, Transaction *txn, const RID &rid) {
+  ASSERT_TRUE(lock_manager->LockExclusive(txn, rid));
+  ASSERT_TRUE(table->MarkDelete(rid, txn));
+  table->ApplyDelete(rid, txn);
+}
+
+/** @return the number of pages in the table's page list */
+auto CountPages(BufferPoolManager *bpm, page_id_t first_page_id) -> size_t {
+  size_t num_pages = 0;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID; num_pages++) {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  return num_pages;
+}
+
+/** @return the number of tuples a scan of the table returns */
+auto CountTuples(TableHeap *table, Transaction *txn) -> size_t {
+  size_t num_tuples = 0;
+  for (auto itr = table->Begin(txn); itr != table->End(); ++itr) {
+    num_tuples++;
+  }
+  return num_tuples;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(VacuumTest, CompactTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  page_id_t page_id;
+  auto *page = reinterpret_cast<TablePage *>(bpm->NewPage(&page_id));
+  ASSERT_NE(nullptr, page);
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, transaction);
+  const uint32_t empty_free_space = page->GetFreeSpaceRemaining();
+
+  RID rids[4];
+  for (auto &rid : rids) {
+    ASSERT_TRUE(page->InsertTuple(tuple, &rid, transaction, nullptr, nullptr));
+  }
+
+  // Scenario: only the empty slots at the end of the slot array are dropped.
+  page->ApplyDelete(rids[1], transaction, nullptr);
+  page->ApplyDelete(rids[3], transaction, nullptr);
+  const uint32_t free_space = page->GetFreeSpaceRemaining();
+  EXPECT_TRUE(page->Compact());
+  EXPECT_EQ(free_space + TablePage::SpaceNeeded(0), page->GetFreeSpaceRemaining());
+  EXPECT_FALSE(page->Compact());
+  RID rid;
+  ASSERT_TRUE(page->GetFirstTupleRid(&rid));
+  EXPECT_EQ(rids[0], rid);
+  ASSERT_TRUE(page->GetNextTupleRid(rids[0], &rid));
+  EXPECT_EQ(rids[2], rid);
+  EXPECT_FALSE(page->GetNextTupleRid(rids[2], &rid));
+
+  // Scenario: a page without tuples compacts down to its header.
+  page->ApplyDelete(rids[2], transaction, nullptr);
+  page->ApplyDelete(rids[0], transaction, nullptr);
+  EXPECT_TRUE(page->Compact());
+  EXPECT_TRUE(page->IsEmpty());
+  EXPECT_EQ(empty_free_space, page->GetFreeSpaceRemaining());
+
+  // Scenario: a sealed page takes no more tuples.
+  page->Seal();
+  EXPECT_EQ(0, page->GetFreeSpaceRemaining());
+  EXPECT_FALSE(page->InsertTuple(tuple, &rid, transaction, nullptr, nullptr));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(VacuumTest, UnlinkTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+  const int num_tuples = 1000;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  const page_id_t first_page_id = table->GetFirstPageId();
+
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+  const page_id_t last_page_id = rids.back().GetPageId();
+  const size_t num_pages = CountPages(bpm, first_page_id);
+  ASSERT_GT(num_pages, 4);
+
+  // Scenario: a pass over a table without deletes changes nothing.
+  TableHeap::VacuumStats stats = table->Vacuum(num_pages);
+  EXPECT_EQ(num_pages, stats.pages_scanned_);
+  EXPECT_EQ(0, stats.pages_compacted_);
+  EXPECT_EQ(0, stats.pages_unlinked_);
+  EXPECT_TRUE(stats.finished_pass_);
+
+  // Empty every page but the first and last, and take every other tuple from the first.
+  size_t num_left = 0;
+  for (int i = 0; i < num_tuples; i++) {
+    const page_id_t page_id = rids[i].GetPageId();
+    if ((page_id == first_page_id && i % 2 == 0) || page_id == last_page_id) {
+      num_left++;
+    } else {
+      DeleteTuple(table, lock_manager, transaction, rids[i]);
+    }
+  }
+
+  // Scenario: vacuum works a few pages at a time, and picks up where it stopped.
+  stats = table->Vacuum(2);
+  EXPECT_EQ(2, stats.pages_scanned_);
+  EXPECT_EQ(1, stats.pages_unlinked_);
+  EXPECT_FALSE(stats.finished_pass_);
+  stats = table->Vacuum(num_pages);
+  EXPECT_EQ(num_pages - 2, stats.pages_scanned_);
+  EXPECT_EQ(num_pages - 3, stats.pages_unlinked_);
+  EXPECT_EQ(num_pages - 3, stats.pages_freed_);
+  EXPECT_TRUE(stats.finished_pass_);
+  EXPECT_EQ(2, CountPages(bpm, first_page_id));
+  EXPECT_EQ(num_left, CountTuples(table, transaction));
+
+  // Scenario: the freed space on the first page is used again; the table does not grow back.
+  const int num_refilled = 4;
+  RID rid;
+  for (int i = 0; i < num_refilled; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    num_left++;
+  }
+  EXPECT_EQ(2, CountPages(bpm, first_page_id));
+
+  // Scenario: a reopened table does not know the freed pages; their ids only come back as new pages of the list.
+  const page_id_t map_page_id = table->GetFreeSpaceMapPageId();
+  delete table;
+  bpm->FlushAllPages();
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id, map_page_id);
+  EXPECT_EQ(num_left, CountTuples(table, transaction));
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+  std::unordered_set<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_ids.insert(page_id);
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  for (const RID &inserted : rids) {
+    EXPECT_EQ(1, page_ids.count(inserted.GetPageId()));
+  }
+  EXPECT_EQ(num_left + num_tuples, CountTuples(table, transaction));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(VacuumTest, IteratorTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+  const int num_tuples = 500;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  const page_id_t first_page_id = table->GetFirstPageId();
+
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+  const page_id_t last_page_id = rids.back().GetPageId();
+
+  // Scenario: pages unlinked under a scan are not freed until it is done, and the scan still sees the tuples left.
+  auto itr = table->Begin(transaction);
+  size_t num_left = 0;
+  for (int i = 0; i < num_tuples; i++) {
+    const page_id_t page_id = rids[i].GetPageId();
+    if (page_id == first_page_id || page_id == last_page_id) {
+      num_left++;
+    } else {
+      DeleteTuple(table, lock_manager, transaction, rids[i]);
+    }
+  }
+  TableHeap::VacuumStats stats = table->Vacuum(num_tuples);
+  ASSERT_GT(stats.pages_unlinked_, 0);
+  EXPECT_EQ(0, stats.pages_freed_);
+  {
+    auto copy = itr;
+    EXPECT_EQ(0, table->Vacuum(0).pages_freed_);
+  }
+  size_t num_scanned = 0;
+  for (; itr != table->End(); ++itr) {
+    num_scanned++;
+  }
+  EXPECT_EQ(num_left, num_scanned);
+
+  // Scenario: once the scan is at its end, the pages are freed.
+  stats = table->Vacuum(0);
+  EXPECT_EQ(0, stats.pages_scanned_);
+  EXPECT_EQ(CountPages(bpm, first_page_id), 2);
+  EXPECT_GT(stats.pages_freed_, 0);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(VacuumTest, BackgroundTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+  const int num_tuples = 1000;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+  const page_id_t first_page_id = table->GetFirstPageId();
+
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rids[i], transaction));
+  }
+  const page_id_t last_page_id = rids.back().GetPageId();
+
+  // Scenario: the background vacuum takes the emptied pages out of the list, a few per round.
+  table->StartVacuum(std::chrono::milliseconds(1), 4);
+  table->StartVacuum(std::chrono::milliseconds(1), 4);
+  for (int i = 0; i < num_tuples; i++) {
+    if (rids[i].GetPageId() != first_page_id && rids[i].GetPageId() != last_page_id) {
+      DeleteTuple(table, lock_manager, transaction, rids[i]);
+    }
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (CountPages(bpm, first_page_id) > 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2, CountPages(bpm, first_page_id));
+  table->StopVacuum();
+  table->StopVacuum();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(VacuumTest, ConcurrentTest) {
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  Tuple tuple{{Value(TypeId::VARCHAR, std::string(100, 'x'))}, &schema};
+  const int num_threads = 4;
+  const int num_rounds = 20;
+  const int tuples_per_round = 100;
+
+  auto *transaction = new Transaction(0, IsolationLevel::READ_COMMITTED);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, transaction);
+
+  // Scenario: inserts, deletes and scans run while the table is vacuumed; no tuple is lost or found twice.
+  table->StartVacuum(std::chrono::milliseconds(1), 8);
+  std::atomic<bool> done{false};
+  std::thread scanner([&] {
+    Transaction scan_txn(num_threads + 1, IsolationLevel::READ_COMMITTED);
+    while (!done) {
+      std::unordered_set<RID> seen;
+      for (auto itr = table->Begin(&scan_txn); itr != table->End(); ++itr) {
+        EXPECT_TRUE(seen.insert(itr->GetRid()).second);
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      Transaction txn(t + 1, IsolationLevel::READ_COMMITTED);
+      std::vector<RID> rids(tuples_per_round);
+      for (int round = 0; round < num_rounds; round++) {
+        for (auto &rid : rids) {
+          ASSERT_TRUE(table->InsertTuple(tuple, &rid, &txn));
+        }
+        // Keep one tuple of every round.
+        for (int i = 1; i < tuples_per_round; i++) {
+          DeleteTuple(table, lock_manager, &txn, rids[i]);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  scanner.join();
+  table->StopVacuum();
+  EXPECT_EQ(num_threads * num_rounds, CountTuples(table, transaction));
+  while (!table->Vacuum(SIZE_MAX).finished_pass_) {
+  }
+  EXPECT_EQ(num_threads * num_rounds, CountTuples(table, transaction));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.space");
+  delete table;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  delete transaction;
+}
+
+}  // namespace bustub